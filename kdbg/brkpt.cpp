@@ -32,6 +32,7 @@ class BreakpointItem : public QTreeWidgetItem, public Breakpoint
 public:
     BreakpointItem(QTreeWidget* list, const Breakpoint& bp);
     void updateFrom(const Breakpoint& bp);
+    void updateRate(double rate);
     void display();			/* sets icon and visible texts */
     bool enabled() const { return Breakpoint::enabled; }
 };
@@ -61,36 +62,28 @@ BreakpointTable::~BreakpointTable()
 {
 }
 
-void BreakpointTable::updateBreakList()
+void BreakpointTable::updateBreakpoint(const Breakpoint& bp)
 {
-    std::list<BreakpointItem*> deletedItems;
+    BreakpointItem*& item = m_items[bp.id];
+    if (item == 0)
+	item = new BreakpointItem(m_ui.bpList, bp);
+    else
+	item->updateFrom(bp);
+}
 
-    for (int i = 0 ; i < m_ui.bpList->topLevelItemCount(); i++)
-    {
-        deletedItems.push_back(static_cast<BreakpointItem*>(m_ui.bpList->topLevelItem(i)));
-    }
+void BreakpointTable::removeBreakpoint(const Breakpoint& bp)
+{
+    delete m_items.take(bp.id);
+}
 
-    // get the new list
-    for (KDebugger::BrkptROIterator bp = m_debugger->breakpointsBegin(); bp != m_debugger->breakpointsEnd(); ++bp)
+void BreakpointTable::updateRates()
+{
+    for (KDebugger::BrkptROIterator bp = m_debugger->breakpointsBegin();
+	 bp != m_debugger->breakpointsEnd(); ++bp)
     {
-	// look up this item
-	for (std::list<BreakpointItem*>::iterator o = deletedItems.begin(); o != deletedItems.end(); ++o)
-	{
-	    if ((*o)->id == bp->id) {
-		(*o)->updateFrom(*bp);
-		deletedItems.erase(o);	/* don't delete */
-		goto nextItem;
-	    }
-	}
-	// not in the list; add it
-	new BreakpointItem(m_ui.bpList,*bp);
-nextItem:;
-    }
-
-    // delete all untouched breakpoints
-    while (!deletedItems.empty()) {
-	delete deletedItems.front();
-	deletedItems.pop_front();
+	BreakpointItem* item = m_items.value(bp->id);
+	if (item != 0)
+	    item->updateRate(bp->hitRate);
     }
 }
 
@@ -107,6 +100,16 @@ void BreakpointItem::updateFrom(const Breakpoint& bp)
     display();
 }
 
+void BreakpointItem::updateRate(double rate)
+{
+    if (rate == hitRate)
+	return;
+    hitRate = rate;
+    // the rate is in the column after the hit count
+    if (hitCount != 0)
+	setText(3, QString().setNum(hitRate, 'g', 3));
+}
+
 void BreakpointTable::on_btAddBP_clicked()
 {
     // set a breakpoint at the specified text
@@ -135,6 +138,23 @@ void BreakpointTable::on_btAddWP_clicked()
     }
 }
 
+void BreakpointTable::on_btAddLP_clicked()
+{
+    /*
+     * Set a logpoint. The text is what gdb's dprintf takes, e.g.
+     * foo.c:42,"x=%d\n",x
+     */
+    QString lpText = m_ui.bpEdit->text();
+    lpText = lpText.trimmed();
+    if (m_debugger->isReady()) {
+	Breakpoint* bp = new Breakpoint;
+	bp->type = Breakpoint::logpoint;
+	bp->text = lpText;
+
+	m_debugger->setBreakpoint(bp, false);
+    }
+}
+
 void BreakpointTable::on_btRemove_clicked()
 {
     BreakpointItem* bp = static_cast<BreakpointItem*>(m_ui.bpList->currentItem());
@@ -168,6 +188,18 @@ void BreakpointTable::updateUI()
     bool enableChkpt = m_debugger->canChangeBreakpoints();
     m_ui.btAddBP->setEnabled(enableChkpt);
     m_ui.btAddWP->setEnabled(enableChkpt);
+    m_ui.btAddLP->setEnabled(enableChkpt);
+
+    // where the time went; a slow condition makes the program run longer
+    qint64 running = m_debugger->runningTime();
+    qint64 stopped = m_debugger->stoppedTime();
+    if (running + stopped == 0) {
+	m_ui.runTimes->clear();
+    } else {
+	m_ui.runTimes->setText(i18n("Running: %1 s, stopped: %2 s")
+			       .arg(running/1000.0, 0, 'f', 1)
+			       .arg(stopped/1000.0, 0, 'f', 1));
+    }
 
     BreakpointItem* bp = static_cast<BreakpointItem*>(m_ui.bpList->currentItem());
     m_ui.btViewCode->setEnabled(bp != 0);
@@ -252,8 +284,9 @@ void BreakpointTable::initListAndIcons()
     m_ui.bpList->setColumnWidth(0, 220);
     m_ui.bpList->setColumnWidth(1, 65);
     m_ui.bpList->setColumnWidth(2, 30);
-    m_ui.bpList->setColumnWidth(3, 30);
-    m_ui.bpList->setColumnWidth(4, 200);
+    m_ui.bpList->setColumnWidth(3, 50);
+    m_ui.bpList->setColumnWidth(4, 30);
+    m_ui.bpList->setColumnWidth(5, 200);
 
     // add pixmaps
     QPixmap brkena = UserIcon("brkena");
@@ -319,7 +352,10 @@ void BreakpointItem::display()
     setIcon(0, lb->m_icons[code]);
 
     // more breakpoint info
-    if (!location.isEmpty()) {
+    if (Breakpoint::type == logpoint && !Breakpoint::text.isEmpty()) {
+	// show the format, too
+	setText(0, Breakpoint::text);
+    } else if (!location.isEmpty()) {
 	setText(0, location);
     } else if (!Breakpoint::text.isEmpty()) {
 	setText(0, Breakpoint::text);
@@ -337,9 +373,12 @@ void BreakpointItem::display()
     QString tmp;
     if (hitCount == 0) {
 	setText(++c, QString());
+	setText(++c, QString());
     } else {
 	tmp.setNum(hitCount);
 	setText(++c, tmp);
+	tmp.setNum(hitRate, 'g', 3);
+	setText(++c, tmp);
     }
     if (ignoreCount == 0) {
 	setText(++c, QString());
@@ -349,6 +388,9 @@ void BreakpointItem::display()
     }
     if (condition.isEmpty()) {
 	setText(++c, QString());
+    } else if (condTarget) {
+	// the program does not stop to evaluate it
+	setText(++c, i18n("%1 (on target)").arg(condition));
     } else {
 	setText(++c, condition);
     }
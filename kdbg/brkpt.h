@@ -9,12 +9,14 @@
 
 #include <QIcon>
 #include <QEvent>
+#include <QHash>
 #include <vector>
 
 #include "ui_brkptbase.h"
 
 class KDebugger;
 class BreakpointItem;
+struct Breakpoint;
 
 
 class BreakpointTable : public QWidget
@@ -29,6 +31,7 @@ protected:
     KDebugger* m_debugger;
     Ui::BrkPtBase m_ui;
     std::vector<QIcon> m_icons;
+    QHash<int,BreakpointItem*> m_items;	/* by breakpoint id */
 
     void insertBreakpoint(int num, bool temp, bool enabled, QString location,
 			  QString fileName = 0, int lineNo = -1,
@@ -54,12 +57,15 @@ signals:
 public slots:
     void on_btAddBP_clicked();
     void on_btAddWP_clicked();
+    void on_btAddLP_clicked();
     void on_btRemove_clicked();
     void on_btEnaDis_clicked();
     void on_btViewCode_clicked();
     void on_btConditional_clicked();
     void updateUI();
-    void updateBreakList();
+    void updateBreakpoint(const Breakpoint& bp);
+    void removeBreakpoint(const Breakpoint& bp);
+    void updateRates();
 };
 
 #endif // BRKPT_H
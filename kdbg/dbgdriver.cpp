@@ -7,6 +7,7 @@
 #include "dbgdriver.h"
 #include "exprwnd.h"
 #include <QStringList>
+#include <QElapsedTimer>
 #include <ctype.h>
 #include <signal.h>
 #include <stdlib.h>			/* strtol, atoi */
@@ -15,9 +16,18 @@
 #include <assert.h>
 
 
+const int DebuggerDriver::defaultArrayPageSize;
+
 DebuggerDriver::DebuggerDriver() :
 	m_state(DSidle),
-	m_activeCmd(0)
+	m_stopGeneration(0),
+	m_activeCmd(0),
+	m_pipelineDepth(1),
+	m_arrayPageSize(defaultArrayPageSize),
+	m_nextToken(0),
+	m_busyCmds(0),
+	m_promptScanned(0),
+	m_logpointScanned(0)
 {
     // debugger process
     connect(this, SIGNAL(readyReadStandardOutput()), SLOT(slotReceiveOutput()));
@@ -30,6 +40,7 @@ DebuggerDriver::~DebuggerDriver()
 {
     flushHiPriQueue();
     flushLoPriQueue();
+    flushPipeline();
 }
 
 
@@ -40,7 +51,9 @@ bool DebuggerDriver::startup(QString cmdStr)
     m_activeCmd = 0;
     flushHiPriQueue();
     flushLoPriQueue();
+    flushPipeline();
     m_state = DSidle;
+    m_statistics.clear();
 
     // debugger executable
     if (cmdStr.isEmpty())
@@ -68,6 +81,16 @@ bool DebuggerDriver::startup(QString cmdStr)
 	m_logFile.setFileName(m_logFileName);
 	m_logFile.open(QIODevice::WriteOnly);
     }
+    if (!m_statsFile.isOpen() && !m_logFileName.isEmpty()) {
+	m_statsFile.setFileName(m_logFileName + ".stats");
+	if (m_statsFile.open(QIODevice::WriteOnly)) {
+	    static const char hdr[] =
+		"# command\twritten\tacked\tfirst output\tdone"
+		" (ms after queued, -1 = never)"
+		"\tbytes\tparse (us)\tExprValues\n";
+	    m_statsFile.write(hdr, sizeof(hdr)-1);
+	}
+    }
 
     return true;
 }
@@ -83,9 +106,20 @@ void DebuggerDriver::slotExited()
     m_state = DSidle;
     // empty buffer
     m_output.clear();
+    m_promptScanned = 0;
+    m_logpointScanned = 0;
 }
 
 
+/*
+ * A batch command consists of several lines, each of which gdb answers
+ * with a prompt.
+ */
+static bool isBatch(const CmdQueueItem* cmd)
+{
+    return cmd->m_cmdString.count('\n') > 1;
+}
+
 CmdQueueItem* DebuggerDriver::executeCmdString(DbgCommand cmd,
 					       QString cmdString, bool clearLow)
 {
@@ -94,7 +128,33 @@ CmdQueueItem* DebuggerDriver::executeCmdString(DbgCommand cmd,
     m_hipriCmdQueue.push(cmdItem);
 
     if (clearLow) {
-	if (m_state == DSrunningLow) {
+	/*
+	 * When this command is executed, the program state changes, and
+	 * the queued low-priority commands that depend on it become stale.
+	 * They are dropped when they are due; all others run afterwards.
+	 */
+	cmdItem->m_newStop = true;
+	if (m_state == DSrunningLow && !m_pipeline.empty()) {
+	    /*
+	     * Commands were sent ahead; an interrupt would abort only one
+	     * of them. Let them run, but ignore their responses.
+	     */
+	    if (dependsOnStop(m_activeCmd->m_cmd))
+		m_activeCmd->m_discard = true;
+	    for (std::list<CmdQueueItem*>::iterator i = m_pipeline.begin(); i != m_pipeline.end(); ++i)
+		if (dependsOnStop((*i)->m_cmd))
+		    (*i)->m_discard = true;
+	} else if (m_state == DSrunningLow && dependsOnStop(m_activeCmd->m_cmd) &&
+		   isBatch(m_activeCmd))
+	{
+	    /*
+	     * A batch sends several commands at once; an interrupt would
+	     * abort only one of them, and the prompts of the others would
+	     * be taken for the response of the next command. Let it run,
+	     * but ignore its response.
+	     */
+	    m_activeCmd->m_discard = true;
+	} else if (m_state == DSrunningLow && dependsOnStop(m_activeCmd->m_cmd)) {
 	    // take the liberty to interrupt the running command
 	    m_state = DSinterrupted;
 	    ::kill(pid(), SIGINT);
@@ -104,7 +164,6 @@ CmdQueueItem* DebuggerDriver::executeCmdString(DbgCommand cmd,
 	    delete m_activeCmd;
 	    m_activeCmd = 0;
 	}
-	flushLoPriQueue();
     }
     // if gdb is idle, send it the command
     if (m_state == DSidle) {
@@ -130,28 +189,35 @@ CmdQueueItem* DebuggerDriver::queueCmdString(DbgCommand cmd,
     case QMoverrideMoreEqual:
     case QMoverride:
 	// check whether gdb is currently processing this command
-	if (m_activeCmd != 0 &&
+	if (m_activeCmd != 0 && !m_activeCmd->m_discard &&
 	    m_activeCmd->m_cmd == cmd && m_activeCmd->m_cmdString == cmdString)
 	{
 	    return m_activeCmd;
 	}
+	// or has it already received the command
+	i = find_if(m_pipeline.begin(), m_pipeline.end(), CmdQueueItem::IsEqualCmd(cmd, cmdString));
+	if (i != m_pipeline.end() && !(*i)->m_discard) {
+	    return *i;
+	}
 	// check whether there is already the same command in the queue
-	i = find_if(m_lopriCmdQueue.begin(), m_lopriCmdQueue.end(), CmdQueueItem::IsEqualCmd(cmd, cmdString));
-	if (i != m_lopriCmdQueue.end()) {
-	    // found one
-	    cmdItem = *i;
+	cmdItem = m_lopriByCmd.value(CmdKey(cmd, cmdString), 0);
+	if (cmdItem != 0) {
+	    // found one; it is wanted in this generation, too
+	    cmdItem->m_generation = m_stopGeneration;
 	    if (mode == QMoverrideMoreEqual) {
 		// All commands are equal, but some are more equal than others...
-		// put this command in front of all others
-		m_lopriCmdQueue.erase(i);
-		m_lopriCmdQueue.push_front(cmdItem);
+		// put this command in front of all others of its class
+		std::list<CmdQueueItem*>& q = lopriQueue(cmdItem->m_priority);
+		q.splice(q.begin(), q, cmdItem->m_lopriPos);
 	    }
 	    break;
 	} // else none found, so add it
 	// drop through
     case QMnormal:
 	cmdItem = new CmdQueueItem(cmd, cmdString);
-	m_lopriCmdQueue.push_back(cmdItem);
+	cmdItem->m_priority = CPvisible;
+	cmdItem->m_generation = m_stopGeneration;
+	pushLoPri(cmdItem);
     }
 
     // if gdb is idle, send it the command
@@ -176,9 +242,8 @@ void DebuggerDriver::writeCommand()
     if (!m_hipriCmdQueue.empty()) {
 	cmd = m_hipriCmdQueue.front();
 	m_hipriCmdQueue.pop();
-    } else if (!m_lopriCmdQueue.empty()) {
-	cmd = m_lopriCmdQueue.front();
-	m_lopriCmdQueue.pop_front();
+    } else if ((cmd = nextLoPri()) != 0) {
+	unlinkLoPri(cmd);
 	newState = DScommandSentLow;
     } else {
 	// nothing to do
@@ -186,10 +251,48 @@ void DebuggerDriver::writeCommand()
 	return;
     }
 
+    if (m_state == DSidle) {
+	// measure how long it takes until the debugger is idle again
+	m_busyTime.start();
+	m_busyCmds = 0;
+    }
+
     m_activeCmd = cmd;
     TRACE("in writeCommand: " + cmd->m_cmdString);
+    if (cmd->m_newStop)
+	m_stopGeneration++;
+
+    cmd->m_token = ++m_nextToken;
+    cmd->m_written = cmd->m_queued.elapsed();
+    m_busyCmds++;
+    QByteArray str = commandText(cmd);
+    if (newState == DScommandSentLow && canPipeline(cmd))
+	sendAhead(str);
+    writeString(str);
 
-    QByteArray str = cmd->m_cmdString.toLocal8Bit();
+    m_state = newState;
+}
+
+void DebuggerDriver::sendAhead(QByteArray& str)
+{
+    CmdQueueItem* cmd;
+    while (int(m_pipeline.size())+1 < m_pipelineDepth &&
+	   (cmd = nextLoPri()) != 0 && canPipeline(cmd))
+    {
+	unlinkLoPri(cmd);
+	TRACE("sending ahead: " + cmd->m_cmdString);
+	cmd->m_token = ++m_nextToken;
+	// there is no acknowledgment for this command of its own
+	cmd->m_committed = true;
+	cmd->m_written = cmd->m_acked = cmd->m_queued.elapsed();
+	m_pipeline.push_back(cmd);
+	m_busyCmds++;
+	str += commandText(cmd);
+    }
+}
+
+void DebuggerDriver::writeString(const QByteArray& str)
+{
     const char* data = str.data();
     qint64 len = str.length();
     while (len > 0) {
@@ -205,16 +308,195 @@ void DebuggerDriver::writeCommand()
 	m_logFile.write(str);
 	m_logFile.flush();
     }
+}
 
-    m_state = newState;
+QByteArray DebuggerDriver::commandText(const CmdQueueItem* cmd) const
+{
+    return cmd->m_cmdString.toLocal8Bit();
+}
+
+bool DebuggerDriver::canPipeline(const CmdQueueItem*) const
+{
+    // by default, responses cannot be told apart
+    return false;
 }
 
 void DebuggerDriver::flushLoPriQueue()
 {
-    while (!m_lopriCmdQueue.empty()) {
-	delete m_lopriCmdQueue.back();
-	m_lopriCmdQueue.pop_back();
+    for (int p = CPvisible; p < CPnum; p++) {
+	std::list<CmdQueueItem*>& q = lopriQueue(CmdPriority(p));
+	while (!q.empty()) {
+	    delete q.back();
+	    q.pop_back();
+	}
     }
+    m_lopriByCmd.clear();
+    m_lopriByVar.clear();
+}
+
+void DebuggerDriver::pushLoPri(CmdQueueItem* cmd)
+{
+    std::list<CmdQueueItem*>& q = lopriQueue(cmd->m_priority);
+    q.push_back(cmd);
+    cmd->m_lopriPos = --q.end();
+    cmd->m_inLoPri = true;
+    m_lopriByCmd.insert(CmdKey(cmd->m_cmd, cmd->m_cmdString), cmd);
+    indexLoPriVars(cmd);
+}
+
+void DebuggerDriver::unlinkLoPri(CmdQueueItem* cmd)
+{
+    ASSERT(cmd->m_inLoPri);
+    lopriQueue(cmd->m_priority).erase(cmd->m_lopriPos);
+    cmd->m_inLoPri = false;
+    m_lopriByCmd.remove(CmdKey(cmd->m_cmd, cmd->m_cmdString), cmd);
+    unindexLoPriVars(cmd);
+}
+
+CmdQueueItem* DebuggerDriver::nextLoPri()
+{
+    for (int p = CPvisible; p < CPnum; p++) {
+	std::list<CmdQueueItem*>& q = lopriQueue(CmdPriority(p));
+	while (!q.empty()) {
+	    CmdQueueItem* cmd = q.front();
+	    if (!isStale(cmd))
+		return cmd;
+	    TRACE("dropping stale cmd: " + cmd->m_cmdString);
+	    unlinkLoPri(cmd);
+	    delete cmd;
+	}
+    }
+    return 0;
+}
+
+bool DebuggerDriver::isStale(const CmdQueueItem* cmd) const
+{
+    return cmd->m_generation != m_stopGeneration && dependsOnStop(cmd->m_cmd);
+}
+
+bool DebuggerDriver::dependsOnStop(DbgCommand cmd)
+{
+    switch (cmd) {
+    case DCinfolocals:
+    case DCinforegisters:
+    case DCexamine:
+    case DCbt:
+    case DCbtrange:
+    case DCframe:
+    case DCthread:
+    case DCinfothreads:
+    case DCprint:
+    case DCprintDeref:
+    case DCprintStruct:
+    case DCprintQStringStruct:
+    case DCprintPopup:
+    case DCprintWChar:
+    case DCprintStructBatch:
+    case DCprintPage:
+    case DCfindType:
+    case DCframelocals:
+    case DCbtall:
+    case DCregistervalues:
+	return true;
+    default:
+	return false;
+    }
+}
+
+void DebuggerDriver::setCmdPriority(CmdQueueItem* cmd, CmdPriority prio)
+{
+    if (!cmd->m_inLoPri || cmd->m_priority == prio || prio == CPuser)
+	return;
+    std::list<CmdQueueItem*>& from = lopriQueue(cmd->m_priority);
+    std::list<CmdQueueItem*>& to = lopriQueue(prio);
+    to.splice(to.end(), from, cmd->m_lopriPos);
+    cmd->m_priority = prio;
+}
+
+QList<CmdQueueItem*> DebuggerDriver::queuedCmdsByVar(VarTree* var) const
+{
+    return m_lopriByVar.values(var->topLevel());
+}
+
+static bool refersTo(const CmdQueueItem* cmd, VarTree* top)
+{
+    if (cmd->m_expr != 0 && cmd->m_expr->topLevel() == top)
+	return true;
+    std::list<ExprBatchItem>::const_iterator i;
+    for (i = cmd->m_batch.begin(); i != cmd->m_batch.end(); ++i) {
+	// expressions that were removed from the batch are 0
+	if (i->m_expr != 0 && i->m_expr->topLevel() == top)
+	    return true;
+    }
+    return false;
+}
+
+bool DebuggerDriver::hasCmdsForVar(VarTree* var) const
+{
+    VarTree* top = var->topLevel();
+    if (m_lopriByVar.contains(top))
+	return true;
+    if (m_activeCmd != 0 && refersTo(m_activeCmd, top))
+	return true;
+    std::list<CmdQueueItem*>::const_iterator i;
+    for (i = m_pipeline.begin(); i != m_pipeline.end(); ++i) {
+	if (refersTo(*i, top))
+	    return true;
+    }
+    return false;
+}
+
+static void addVarKey(std::list<VarTree*>& keys, VarTree* expr)
+{
+    if (expr == 0)
+	return;
+    VarTree* top = expr->topLevel();
+    if (std::find(keys.begin(), keys.end(), top) == keys.end())
+	keys.push_back(top);
+}
+
+void DebuggerDriver::indexLoPriVars(CmdQueueItem* cmd)
+{
+    unindexLoPriVars(cmd);
+
+    addVarKey(cmd->m_varKeys, cmd->m_expr);
+    std::list<ExprBatchItem>::iterator i;
+    for (i = cmd->m_batch.begin(); i != cmd->m_batch.end(); ++i)
+	addVarKey(cmd->m_varKeys, i->m_expr);
+
+    std::list<VarTree*>::iterator k;
+    for (k = cmd->m_varKeys.begin(); k != cmd->m_varKeys.end(); ++k)
+	m_lopriByVar.insert(*k, cmd);
+}
+
+void DebuggerDriver::unindexLoPriVars(CmdQueueItem* cmd)
+{
+    while (!cmd->m_varKeys.empty()) {
+	m_lopriByVar.remove(cmd->m_varKeys.front(), cmd);
+	cmd->m_varKeys.pop_front();
+    }
+}
+
+void DebuggerDriver::setCmdExpr(CmdQueueItem* cmd, VarTree* expr, ExprWnd* wnd)
+{
+    cmd->m_expr = expr;
+    cmd->m_exprWnd = wnd;
+    if (cmd->m_inLoPri)
+	indexLoPriVars(cmd);
+}
+
+CmdQueueItem* DebuggerDriver::executeBreakBatch(const QString& lines, bool queueOnly)
+{
+    if (queueOnly)
+	return queueCmdString(DCbreakbatch, lines, QMoverride);
+    return executeCmdString(DCbreakbatch, lines, false);
+}
+
+void DebuggerDriver::setCmdBatch(CmdQueueItem* cmd, const std::list<ExprBatchItem>& batch)
+{
+    cmd->m_batch = batch;
+    if (cmd->m_inLoPri)
+	indexLoPriVars(cmd);
 }
 
 void DebuggerDriver::flushHiPriQueue()
@@ -225,6 +507,14 @@ void DebuggerDriver::flushHiPriQueue()
     }
 }
 
+void DebuggerDriver::flushPipeline()
+{
+    while (!m_pipeline.empty()) {
+	delete m_pipeline.back();
+	m_pipeline.pop_back();
+    }
+}
+
 void DebuggerDriver::flushCommands(bool hipriOnly)
 {
     flushHiPriQueue();
@@ -237,13 +527,17 @@ void DebuggerDriver::slotCommandRead()
 {
     TRACE(__PRETTY_FUNCTION__);
 
+    // commands that are sent ahead do not change the state
+    if (m_state != DScommandSent && m_state != DScommandSentLow)
+	return;
+
     // there must be an active command which is not yet commited
-    ASSERT(m_state == DScommandSent || m_state == DScommandSentLow);
     ASSERT(m_activeCmd != 0);
     ASSERT(!m_activeCmd->m_committed);
 
     // commit the command
     m_activeCmd->m_committed = true;
+    m_activeCmd->m_acked = m_activeCmd->m_queued.elapsed();
 
     // now the debugger is officially working on the command
     m_state = m_state == DScommandSent ? DSrunning : DSrunningLow;
@@ -269,6 +563,9 @@ void DebuggerDriver::slotReceiveOutput()
 {
     QByteArray data = readAllStandardOutput();
 
+    if (m_activeCmd != 0 && m_activeCmd->m_firstOutput < 0)
+	m_activeCmd->m_firstOutput = m_activeCmd->m_queued.elapsed();
+
     /*
      * The debugger should be running (processing a command) at this point.
      * If it is not, it is still idle because we haven't received the
@@ -289,6 +586,12 @@ void DebuggerDriver::slotReceiveOutput()
     processOutput(data);
 }
 
+int DebuggerDriver::extractLogpointOutput(QByteArray&, int start, QStringList&)
+{
+    // the driver does not support logpoints
+    return start;
+}
+
 void DebuggerDriver::processOutput(const QByteArray& data)
 {
     // write to log file (do not log delayed output - it would appear twice)
@@ -316,12 +619,22 @@ void DebuggerDriver::processOutput(const QByteArray& data)
     // accumulate it
     m_output += data;
 
+    // logpoints print while the program runs; don't let that pile up
+    QStringList log;
+    m_logpointScanned = extractLogpointOutput(m_output,
+				qMax(m_logpointScanned, m_promptScanned), log);
+    if (!log.isEmpty())
+	emit logpointOutput(log);
+
     // check for a prompt
-    int promptStart = findPrompt(m_output);
-    if (promptStart >= 0)
+    int promptStart, promptEnd;
+    while ((promptStart = findPrompt(m_output, m_promptScanned, promptEnd)) >= 0)
     {
 	// found prompt!
 
+	// output after the prompt belongs to commands that were sent ahead
+	QByteArray rest = m_output.mid(promptEnd);
+
 	// terminate output before the prompt
 	m_output.resize(promptStart);
 
@@ -338,48 +651,177 @@ void DebuggerDriver::processOutput(const QByteArray& data)
 	    ASSERT(m_state != DSidle);
 	    CmdQueueItem* cmd = m_activeCmd;
 	    m_activeCmd = 0;
-	    commandFinished(cmd);
+	    cmd->m_done = cmd->m_queued.elapsed();
+	    if (!cmd->m_discard)
+		parseOutput(cmd);
+	    recordStatistics(cmd);
 	    delete cmd;
 	}
 
 	// empty buffer
-	m_output.clear();
+	m_output = rest;
+	m_promptScanned = 0;
+	m_logpointScanned = 0;
 	// also clear delayed output if interrupted
 	if (m_state == DSinterrupted) {
 	    m_delayedOutput = std::queue<QByteArray>();
 	}
 
+	/*
+	 * If commands were sent ahead, the next one is active now; its
+	 * output may have been collected already. Keep the pipeline filled
+	 * unless a high-priority command waits.
+	 */
+	if (!m_pipeline.empty()) {
+	    m_activeCmd = m_pipeline.front();
+	    m_pipeline.pop_front();
+	    // its output arrived together with that of the previous command
+	    if (!m_output.isEmpty())
+		m_activeCmd->m_firstOutput = m_activeCmd->m_queued.elapsed();
+	    if (m_hipriCmdQueue.empty() && !m_activeCmd->m_discard) {
+		QByteArray str;
+		sendAhead(str);
+		if (!str.isEmpty())
+		    writeString(str);
+	    }
+	    continue;
+	}
+	m_output.clear();
+
 	/*
 	 * We parsed some output successfully. Unless there's more delayed
 	 * output, the debugger must be idle now, so send down the next
 	 * command.
 	 */
 	if (m_delayedOutput.empty()) {
-	    if (m_hipriCmdQueue.empty() && m_lopriCmdQueue.empty()) {
+	    if (m_hipriCmdQueue.empty() && nextLoPri() == 0) {
 		// no pending commands
 		m_state = DSidle;
+		logIdleTime();
 		emit enterIdleState();
 	    } else {
 		writeCommand();
 	    }
 	}
+	break;
+    }
+}
+
+/*
+ * Records in the transcript how long the debugger was busy since it left
+ * idle state, so that different pipeline depths can be compared.
+ */
+void DebuggerDriver::logIdleTime()
+{
+    if (!m_logFile.isOpen() || m_busyCmds == 0)
+	return;
+
+    QString txt;
+    txt.sprintf("\n====== idle after %d ms, %d commands, pipeline depth %d ======\n",
+		m_busyTime.elapsed(), m_busyCmds, m_pipelineDepth);
+    m_logFile.write(txt.toLatin1());
+    m_logFile.flush();
+    m_busyCmds = 0;
+}
+
+/*
+ * The time includes the work of the receivers of commandReceived(); for
+ * most commands, that is where the output is parsed.
+ */
+void DebuggerDriver::parseOutput(CmdQueueItem* cmd)
+{
+    cmd->m_outputSize = m_output.size();
+    unsigned long allocs = ExprValue::allocations();
+    QElapsedTimer timer;
+    timer.start();
+
+    commandFinished(cmd);
+
+    cmd->m_parseTime = int(timer.nsecsElapsed() / 1000);
+    cmd->m_allocations = int(ExprValue::allocations() - allocs);
+}
+
+void DebuggerDriver::recordStatistics(CmdQueueItem* cmd)
+{
+    m_statistics[cmd->m_cmd].add(cmd);
+
+    if (m_statsFile.isOpen()) {
+	QString txt;
+	txt.sprintf("%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\n", commandName(cmd->m_cmd),
+		    cmd->m_written, cmd->m_acked, cmd->m_firstOutput, cmd->m_done,
+		    cmd->m_outputSize, cmd->m_parseTime, cmd->m_allocations);
+	m_statsFile.write(txt.toLatin1());
+	m_statsFile.flush();
     }
 }
 
+const char* DebuggerDriver::commandName(DbgCommand cmd)
+{
+    static const char* const names[] = {
+	"DCinitialize", "DCtty", "DCexecutable", "DCtargetremote",
+	"DCcorefile", "DCattach", "DCinfolinemain", "DCinfolocals",
+	"DCinforegisters", "DCexamine", "DCinfoline", "DCdisassemble",
+	"DCsetargs", "DCsetenv", "DCunsetenv", "DCsetoption", "DCcd",
+	"DCbt", "DCrun", "DCcont", "DCstep", "DCstepi", "DCnext",
+	"DCnexti", "DCfinish", "DCuntil", "DCkill", "DCbreaktext",
+	"DCbreakline", "DCtbreakline", "DCbreakaddr", "DCtbreakaddr",
+	"DCwatchpoint", "DCdelete", "DCenable", "DCdisable", "DCprint",
+	"DCprintDeref", "DCprintStruct", "DCprintQStringStruct",
+	"DCprintPopup", "DCframe", "DCfindType", "DCinfosharedlib",
+	"DCthread", "DCinfothreads", "DCinfobreak", "DCcondition",
+	"DCsetpc", "DCignore", "DCprintWChar", "DCsetvariable",
+	"DCprintStructBatch", "DCprintPage", "DCframelocals",
+	"DCbtall", "DCregistervalues", "DCbreakbatch", "DClogpoint",
+	"DCtargetcond", "DCbtrange",
+    };
+    if (unsigned(cmd) < sizeof(names)/sizeof(names[0]))
+	return names[cmd];
+    return "?";
+}
+
 void DebuggerDriver::dequeueCmdByVar(VarTree* var)
 {
     if (var == 0)
 	return;
 
-    std::list<CmdQueueItem*>::iterator i = m_lopriCmdQueue.begin();
-    while (i != m_lopriCmdQueue.end()) {
+    // a batch must be evaluated for the remaining expressions
+    if (m_activeCmd != 0)
+	dequeueBatchByVar(m_activeCmd, var);
+
+    // commands that were sent ahead cannot be revoked
+    for (std::list<CmdQueueItem*>::iterator i = m_pipeline.begin(); i != m_pipeline.end(); ++i)
+    {
+	dequeueBatchByVar(*i, var);
 	if ((*i)->m_expr != 0 && var->isAncestorEq((*i)->m_expr)) {
+	    TRACE("ignoring response of critical cmd: " + (*i)->m_cmdString);
+	    (*i)->m_discard = true;
+	}
+    }
+
+    // only the commands of the same top-level expression are candidates
+    QList<CmdQueueItem*> cands = m_lopriByVar.values(var->topLevel());
+    for (QList<CmdQueueItem*>::iterator i = cands.begin(); i != cands.end(); ++i)
+    {
+	CmdQueueItem* cmd = *i;
+	dequeueBatchByVar(cmd, var);
+	if (cmd->m_expr != 0 && var->isAncestorEq(cmd->m_expr)) {
 	    // this is indeed a critical command; delete it
-	    TRACE("removing critical lopri-cmd: " + (*i)->m_cmdString);
-	    delete *i;
-	    m_lopriCmdQueue.erase(i++);
-	} else
-	    ++i;
+	    TRACE("removing critical lopri-cmd: " + cmd->m_cmdString);
+	    unlinkLoPri(cmd);
+	    delete cmd;
+	}
+    }
+}
+
+void DebuggerDriver::dequeueBatchByVar(CmdQueueItem* cmd, VarTree* var)
+{
+    std::list<ExprBatchItem>::iterator i;
+    for (i = cmd->m_batch.begin(); i != cmd->m_batch.end(); ++i)
+    {
+	if (i->m_expr != 0 && var->isAncestorEq(i->m_expr)) {
+	    TRACE("removing expression from batch: " + cmd->m_cmdString);
+	    i->m_expr = 0;
+	}
     }
 }
 
@@ -447,13 +889,59 @@ bool operator>(const DbgAddr& a1, const DbgAddr& a2)
 }
 
 
+CmdStatistics::CmdStatistics() :
+	count(0),
+	totalWait(0),
+	totalAck(0),
+	totalFirst(0),
+	totalDone(0),
+	maxDone(0),
+	totalBytes(0),
+	totalParse(0),
+	totalAllocs(0)
+{
+    for (int i = 0; i < numBuckets; i++)
+	histogram[i] = 0;
+}
+
+void CmdStatistics::add(const CmdQueueItem* cmd)
+{
+    count++;
+    totalWait += cmd->m_written;
+    if (cmd->m_acked >= 0)
+	totalAck += cmd->m_acked - cmd->m_written;
+    if (cmd->m_firstOutput >= 0)
+	// output can arrive before the acknowledgment
+	totalFirst += std::max(0, cmd->m_firstOutput - std::max(cmd->m_acked, cmd->m_written));
+    totalDone += cmd->m_done;
+    if (cmd->m_done > maxDone)
+	maxDone = cmd->m_done;
+    totalBytes += cmd->m_outputSize;
+    totalParse += cmd->m_parseTime;
+    totalAllocs += cmd->m_allocations;
+
+    int b = 0;
+    while (bucketLimit(b) >= 0 && cmd->m_done >= bucketLimit(b))
+	b++;
+    histogram[b]++;
+}
+
+int CmdStatistics::bucketLimit(int i)
+{
+    // 1, 4, 16, ... milliseconds; the last bucket is unbounded
+    return i < numBuckets-1 ? 1 << (2*i) : -1;
+}
+
+
 Breakpoint::Breakpoint() :
 	id(0),
 	type(breakpoint),
 	temporary(false),
 	enabled(true),
+	condTarget(false),
 	ignoreCount(0),
 	hitCount(0),
+	hitRate(0),
 	lineNo(0)
 { }
 
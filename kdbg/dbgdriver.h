@@ -10,8 +10,12 @@
 #include <QFile>
 #include <QByteArray>
 #include <QProcess>
+#include <QTime>
+#include <QHash>
+#include <QPair>
 #include <queue>
 #include <list>
+#include <map>
 
 
 class VarTree;
@@ -94,7 +98,16 @@ enum DbgCommand {
 	DCsetpc,
 	DCignore,
 	DCprintWChar,
-	DCsetvariable
+	DCsetvariable,
+	DCprintStructBatch,		/* one DCprintStruct per line */
+	DCprintPage,			/* more elements of an array */
+	DCframelocals,			/* locals of a frame other than the current */
+	DCbtall,			/* backtraces of all threads */
+	DCregistervalues,		/* values of the named registers */
+	DCbreakbatch,			/* one DCbreak* command per line */
+	DClogpoint,			/* print and continue at a location */
+	DCtargetcond,			/* let the target evaluate conditions */
+	DCbtrange			/* frames from level to level */
 };
 
 enum RunDevNull {
@@ -129,8 +142,41 @@ enum MemoryDumpType {
     MDTformatmask = 0xf0
 };
 
+/**
+ * The classes of commands, in the order in which they are executed.
+ * Commands of the user class go into the high-priority queue, all
+ * others into the low-priority queue.
+ */
+enum CmdPriority {
+    CPuser,				/* requested by the user */
+    CPvisible,				/* refreshes what is in view */
+    CPoffscreen,			/* refreshes what is not in view */
+    CPprefetch,				/* may be needed later */
+    CPnum
+};
+
 struct Breakpoint;
 
+/**
+ * A breakpoint that is set as part of a DCbreakbatch.
+ */
+struct BrkptBatchItem
+{
+    BrkptBatchItem(Breakpoint* bp, int existing) : m_brkpt(bp), m_existingBrkpt(existing) { }
+    Breakpoint* m_brkpt;		/* a new breakpoint, or 0 */
+    int m_existingBrkpt;		/* the id of an orphaned breakpoint */
+};
+
+/**
+ * An expression that is evaluated as part of a DCprintStructBatch.
+ */
+struct ExprBatchItem
+{
+    ExprBatchItem(VarTree* expr, ExprWnd* wnd) : m_expr(expr), m_exprWnd(wnd) { }
+    VarTree* m_expr;			/* 0 if it was removed meanwhile */
+    ExprWnd* m_exprWnd;
+};
+
 /**
  * Debugger commands are placed in a queue. Only one command at a time is
  * sent down to the debugger. All other commands in the queue are retained
@@ -138,6 +184,9 @@ struct Breakpoint;
  * that it's done with the command by sending the prompt. The output of the
  * debugger is parsed at that time. Then, if more commands are in the
  * queue, the next one is sent to the debugger.
+ *
+ * If the driver supports it, a number of low-priority commands can be
+ * sent ahead; they are still processed one after the other.
  */
 struct CmdQueueItem
 {
@@ -147,6 +196,8 @@ struct CmdQueueItem
     // remember which expression when printing an expression
     VarTree* m_expr;
     ExprWnd* m_exprWnd;
+    // the pointer whose target the lightweight Locals view waits for
+    QString m_modelExpr;
     // remember file position
     QString m_fileName;
     int m_lineNo;
@@ -158,6 +209,42 @@ struct CmdQueueItem
     bool m_byUser;
     // used to store the expression to print in case of DCprintPopup is executed
     QString m_popupExpr;
+    // the key under which the result of DCfindType is cached
+    QString m_typeKey;
+    // sequence number that drivers can use to match the response
+    int m_token;
+    // the command was sent ahead, but its response is no longer of interest
+    bool m_discard;
+    // remember the expressions of a DCprintStructBatch, one per line
+    std::list<ExprBatchItem> m_batch;
+    // remember the breakpoints of a DCbreakbatch, one per line
+    std::list<BrkptBatchItem> m_brkptBatch;
+    // the class of the command
+    CmdPriority m_priority;
+    // the stop generation in which the command was queued
+    int m_generation;
+    // the frame whose locals DCframelocals lists, or the first frame
+    // that DCbt adds to the backtrace that is shown
+    int m_frameNo;
+    // whether executing the command changes the state of the program
+    bool m_newStop;
+    // the position in the low-priority queue and the top-level
+    // expressions under which the command is indexed there
+    bool m_inLoPri;
+    std::list<CmdQueueItem*>::iterator m_lopriPos;
+    std::list<VarTree*> m_varKeys;
+    // when the command was queued, and milliseconds since then when it was
+    // written, acknowledged, produced output, and finished (-1 if not yet)
+    QTime m_queued;
+    int m_written;
+    int m_acked;
+    int m_firstOutput;
+    int m_done;
+    // the size of the output, and the microseconds and number of
+    // ExprValues that were needed to parse it
+    int m_outputSize;
+    int m_parseTime;
+    int m_allocations;
 
     CmdQueueItem(DbgCommand cmd, const QString& str) :
     	m_cmd(cmd),
@@ -168,8 +255,22 @@ struct CmdQueueItem
 	m_lineNo(0),
 	m_brkpt(0),
 	m_existingBrkpt(0),
-	m_byUser(false)
-    { }
+	m_byUser(false),
+	m_token(0),
+	m_discard(false),
+	m_priority(CPuser),
+	m_generation(0),
+	m_frameNo(-1),
+	m_newStop(false),
+	m_inLoPri(false),
+	m_written(-1),
+	m_acked(-1),
+	m_firstOutput(-1),
+	m_done(-1),
+	m_outputSize(0),
+	m_parseTime(0),
+	m_allocations(0)
+    { m_queued.start(); }
 
     struct IsEqualCmd
     {
@@ -180,6 +281,30 @@ struct CmdQueueItem
     };
 };
 
+/**
+ * Accumulated timings of the commands of one kind, in milliseconds.
+ */
+struct CmdStatistics
+{
+    enum { numBuckets = 8 };
+    CmdStatistics();
+    /** Adds the timings of a finished command. */
+    void add(const CmdQueueItem* cmd);
+    /** The upper limit (exclusive) of histogram bucket \a i or -1. */
+    static int bucketLimit(int i);
+
+    int count;				/* commands finished */
+    int totalWait;			/* from queued until written */
+    int totalAck;			/* from written until acknowledged */
+    int totalFirst;			/* from acknowledged until first output */
+    int totalDone;			/* from queued until the prompt */
+    int maxDone;
+    int histogram[numBuckets];		/* of the times until the prompt */
+    double totalBytes;			/* output parsed */
+    double totalParse;			/* microseconds spent parsing */
+    double totalAllocs;			/* ExprValues created while parsing */
+};
+
 /**
  * The information about a breakpoint that is parsed from the list of
  * breakpoints.
@@ -188,16 +313,18 @@ struct Breakpoint
 {
     int id;				/* gdb's number */
     enum Type {
-	breakpoint, watchpoint 
+	breakpoint, watchpoint, logpoint
     } type;
     bool temporary;
     bool enabled;
     QString location;
-    QString text;			/* text if set using DCbreaktext */
+    QString text;			/* text if set using DCbreaktext or DClogpoint */
     DbgAddr address;			/* exact address of breakpoint */
     QString condition;			/* condition as printed by gdb */
+    bool condTarget;			/* the target evaluates the condition */
     int ignoreCount;			/* ignore next that may hits */
     int hitCount;			/* as reported by gdb */
+    double hitRate;			/* hits per second of running time */
     // the following items repeat the location, but in a better usable way
     QString fileName;
     int lineNo;				/* zero-based line number */
@@ -237,6 +364,25 @@ struct ThreadInfo : FrameInfo
     bool hasFocus;			/* the thread whose stack we are watching */
 };
 
+/**
+ * A stack frame as listed in the backtraces of all threads.
+ */
+struct ThreadFrame : FrameInfo
+{
+    int frameNo;
+    QString function;			/* as printed by the debugger */
+};
+
+/**
+ * The backtrace of one thread.
+ */
+struct ThreadStack
+{
+    int id;				/* gdb's number */
+    QString threadName;			/* the SYSTAG */
+    std::list<ThreadFrame> frames;	/* innermost frame first */
+};
+
 /**
  * Register information
  */
@@ -291,8 +437,51 @@ public:
      */
     virtual QStringList boolOptionList() const = 0;
 
+    /**
+     * Tells whether DCframelocals works, i.e. whether the debugger can
+     * list the locals of a frame without selecting it.
+     */
+    virtual bool canListFrameLocals() const { return false; }
+
+    /**
+     * Tells whether DCbtrange works, i.e. whether the debugger can list
+     * the frames of a range of levels without listing the inner frames.
+     */
+    virtual bool canListFrameRange() const { return false; }
+
+    /**
+     * Tells whether DCbreakbatch works, i.e. whether the outputs of the
+     * lines of a batch can be told apart.
+     */
+    virtual bool canBatchBreakpoints() const { return false; }
+
     virtual bool startup(QString cmdStr);
     void setLogFileName(const QString& fname) { m_logFileName = fname; }
+    /**
+     * Sets how many low-priority commands may be sent to the debugger
+     * before the response of the first one has arrived. Only drivers that
+     * can match responses to commands make use of this.
+     */
+    void setPipelineDepth(int depth) { m_pipelineDepth = depth < 1 ? 1 : depth; }
+    /** the number of array elements that gdb prints by default */
+    static const int defaultArrayPageSize = 200;
+    /**
+     * Sets how many elements of an array the debugger prints at once;
+     * 0 means all of them. The remaining elements are fetched page by
+     * page when the user asks for them.
+     */
+    void setArrayPageSize(int n) { m_arrayPageSize = n < 0 ? 0 : n; }
+    int arrayPageSize() const { return m_arrayPageSize; }
+    /**
+     * Returns the timings of the commands that finished since the
+     * debugger was started, by command.
+     */
+    const std::map<DbgCommand,CmdStatistics>& statistics() const { return m_statistics; }
+    void resetStatistics() { m_statistics.clear(); }
+    /**
+     * Returns a printable name of the command, e.g. "DCinfolocals".
+     */
+    static const char* commandName(DbgCommand cmd);
     bool isRunning() { return state() != NotRunning; }
 
 protected:
@@ -310,6 +499,11 @@ protected:
 
 public:
     bool isIdle() const { return m_state == DSidle; }
+    /**
+     * Counts the commands that were written and changed the state of the
+     * program; see CmdQueueItem::m_newStop.
+     */
+    int stopGeneration() const { return m_stopGeneration; }
     /**
      * Tells whether a high prority command would be executed immediately.
      */
@@ -358,6 +552,22 @@ public:
 				   QueueMode mode) = 0;
     virtual CmdQueueItem* queueCmd(DbgCommand, QString strArg1, QString strArg2,
 				   QueueMode mode) = 0;
+    virtual CmdQueueItem* queueCmd(DbgCommand, int intArg1, int intArg2,
+				   QueueMode mode) = 0;
+
+    /**
+     * Returns the text of a command that takes a string argument and
+     * possibly a number, without enqueueing it.
+     */
+    virtual QString commandString(DbgCommand cmd, QString strArg, int intArg) = 0;
+
+    /**
+     * Enqueues a DCbreakbatch. The lines are obtained from
+     * commandString(); each of them sets one breakpoint.
+     * @param queueOnly if true, the command is put in the low-priority
+     * queue.
+     */
+    CmdQueueItem* executeBreakBatch(const QString& lines, bool queueOnly);
 
     /**
      * Flushes the command queues.
@@ -393,8 +603,10 @@ public:
 
     /**
      * Parses a back-trace (the output of the DCbt command).
+     * @return true if the debugger said that more frames follow than
+     * were listed.
      */
-    virtual void parseBackTrace(const char* output, std::list<StackFrame>& stack) = 0;
+    virtual bool parseBackTrace(const char* output, std::list<StackFrame>& stack) = 0;
 
     /**
      * Parses the output of the DCframe command;
@@ -426,6 +638,14 @@ public:
      */
     virtual std::list<ThreadInfo> parseThreadList(const char* output) = 0;
 
+    /**
+     * Parses the backtraces of all threads.
+     * @param output The output of the debugger.
+     * @return The backtraces in the order in which the debugger lists
+     * the threads. There is no indication if there was a parse error.
+     */
+    virtual std::list<ThreadStack> parseThreadStacks(const char* output) = 0;
+
     /**
      * Parses the output when the program stops to see whether this it
      * stopped due to a breakpoint.
@@ -459,6 +679,13 @@ public:
      */
     virtual ExprValue* parsePrintExpr(const char* output, bool wantErrorValue) = 0;
 
+    /**
+     * Splits the output of a DCprintStructBatch or DCbreakbatch command
+     * into the outputs of the individual lines. Each of them can be
+     * handed to parsePrintExpr or parseBreakpoint, respectively.
+     */
+    virtual std::list<QByteArray> parseBatchOutput(const char* output) = 0;
+
     /**
      * Parses the output of the DCcd command.
      * @return false if the message is an error message.
@@ -540,13 +767,64 @@ protected:
     void flushLoPriQueue();
     /** Removes all commands from  the high-priority queue. */
     void flushHiPriQueue();
+    /** Forgets the commands that were sent ahead. */
+    void flushPipeline();
+    /** Records the time since the debugger left idle state. */
+    void logIdleTime();
+    /** Accounts the timings of a finished command. */
+    void recordStatistics(CmdQueueItem* cmd);
+    /** Hands the output to commandFinished() and measures the cost. */
+    void parseOutput(CmdQueueItem* cmd);
+    /** Forgets the expressions of a batch that belong to var. */
+    void dequeueBatchByVar(CmdQueueItem* cmd, VarTree* var);
+
+    /** Appends a command to the low-priority queue. */
+    void pushLoPri(CmdQueueItem* cmd);
+    /**
+     * Returns the next low-priority command that is still of interest or
+     * 0. Commands that are stale are dropped on the way.
+     */
+    CmdQueueItem* nextLoPri();
+    bool isStale(const CmdQueueItem* cmd) const;
+    std::list<CmdQueueItem*>& lopriQueue(CmdPriority prio)
+    { return m_lopriCmdQueue[prio-CPvisible]; }
+    /** Takes a command out of the low-priority queue. */
+    void unlinkLoPri(CmdQueueItem* cmd);
+    /** Indexes the command by the top-level expressions that it uses. */
+    void indexLoPriVars(CmdQueueItem* cmd);
+    void unindexLoPriVars(CmdQueueItem* cmd);
 
     std::queue<CmdQueueItem*> m_hipriCmdQueue;
-    std::list<CmdQueueItem*> m_lopriCmdQueue;
+    std::list<CmdQueueItem*> m_lopriCmdQueue[CPnum-CPvisible];
+    /**
+     * Counts the commands that run the program. Low-priority commands
+     * that depend on the program state and were queued before the last
+     * of them was executed are stale.
+     */
+    int m_stopGeneration;
+    /**
+     * The low-priority commands are indexed by command and command
+     * string, so that an equal command is found quickly, and by the
+     * top-level expressions that they evaluate, so that the commands of
+     * an expression that goes away are found quickly.
+     */
+    typedef QPair<int,QString> CmdKey;
+    QMultiHash<CmdKey,CmdQueueItem*> m_lopriByCmd;
+    QMultiHash<VarTree*,CmdQueueItem*> m_lopriByVar;
     /**
      * The active command is kept separately from other pending commands.
      */
     CmdQueueItem* m_activeCmd;
+    /**
+     * Low-priority commands that were sent ahead of the active command
+     * and whose responses are still outstanding, in order.
+     */
+    std::list<CmdQueueItem*> m_pipeline;
+    int m_pipelineDepth;
+    int m_arrayPageSize;
+    int m_nextToken;
+    QTime m_busyTime;			/* since the debugger left idle state */
+    int m_busyCmds;			/* commands sent since then */
     /**
      * Helper function that queues the given command string in the
      * low-priority queue.
@@ -560,21 +838,93 @@ protected:
     CmdQueueItem* executeCmdString(DbgCommand cmd, QString cmdString,
 				   bool clearLow);
     void writeCommand();
+    /**
+     * Appends to \a str low-priority commands that can be sent ahead of
+     * the active command.
+     */
+    void sendAhead(QByteArray& str);
+    void writeString(const QByteArray& str);
     virtual void commandFinished(CmdQueueItem* cmd) = 0;
+    /**
+     * Returns the text that is sent to the debugger for \a cmd.
+     */
+    virtual QByteArray commandText(const CmdQueueItem* cmd) const;
+    /**
+     * Tells whether \a cmd can be sent to the debugger while the
+     * responses of earlier commands are still outstanding. The driver
+     * must be able to tell the responses apart in findPrompt(), and the
+     * command must not change the debugger's state.
+     */
+    virtual bool canPipeline(const CmdQueueItem* cmd) const;
 
 protected:
     void processOutput(const QByteArray& data);
 
     /**
-     * Returns the start of the prompt in \a output or -1.
-     * \a len specifies the size of \a output, but in addition, the contents
-     * of \a output are NUL-terminated, i.e., \c output[len] is zero.
+     * Returns the start of the prompt that terminates the output of the
+     * active command in \a output or -1. \a promptEnd receives the offset
+     * after the prompt; anything that follows belongs to commands that
+     * were sent ahead.
+     * Output is passed in again each time more of it arrives. The driver
+     * can advance \a scanned over the part that it has examined, so that
+     * it need not look at it again; it is 0 for the output of a new
+     * command.
+     * The contents of \a output are NUL-terminated, i.e.,
+     * \c output[output.length()] is zero.
+     */
+    virtual int findPrompt(const QByteArray& output, int& scanned, int& promptEnd) = 0;
+    int m_promptScanned;		/* see findPrompt() */
+
+    /**
+     * Removes the lines that logpoints printed from \a output and appends
+     * their text to \a lines. Only complete lines at or after offset
+     * \a start are examined. Returns the offset after the last complete
+     * line, where the next call should start.
      */
-    virtual int findPrompt(const QByteArray& output) const = 0;
+    virtual int extractLogpointOutput(QByteArray& output, int start, QStringList& lines);
+    int m_logpointScanned;		/* see extractLogpointOutput() */
 
     // log file
     QString m_logFileName;
     QFile m_logFile;
+    // the timings of each command go next to the log file
+    QFile m_statsFile;
+    std::map<DbgCommand,CmdStatistics> m_statistics;
+
+public:
+    /**
+     * Remembers that \a cmd evaluates the expression \a expr, which is
+     * shown in \a wnd. The command is removed from the queue when expr
+     * goes away; see dequeueCmdByVar().
+     */
+    void setCmdExpr(CmdQueueItem* cmd, VarTree* expr, ExprWnd* wnd);
+    /**
+     * Remembers the expressions that \a cmd, a DCprintStructBatch,
+     * evaluates.
+     */
+    void setCmdBatch(CmdQueueItem* cmd, const std::list<ExprBatchItem>& batch);
+    /**
+     * Moves a low-priority command to the end of the queue of the class
+     * \a prio. Commands of the class CPvisible are executed before those
+     * of CPoffscreen, and these before CPprefetch.
+     */
+    void setCmdPriority(CmdQueueItem* cmd, CmdPriority prio);
+    /**
+     * Returns the low-priority commands that evaluate parts of the
+     * top-level expression of \a var.
+     */
+    QList<CmdQueueItem*> queuedCmdsByVar(VarTree* var) const;
+    /**
+     * Tells whether a command that evaluates a part of the top-level
+     * expression of \a var is queued, sent, or active.
+     */
+    bool hasCmdsForVar(VarTree* var) const;
+    /**
+     * Tells whether the result of the command depends on the state of
+     * the program. Such commands are dropped from the low-priority queue
+     * when the program was run in the meantime.
+     */
+    static bool dependsOnStop(DbgCommand cmd);
 
 public slots:
     void dequeueCmdByVar(VarTree* var);
@@ -591,6 +941,12 @@ signals:
      */
     void commandReceived(CmdQueueItem* cmd, const char* output);
 
+    /**
+     * This signal is emitted when logpoints have printed something. The
+     * program keeps running; the lines are reported as they arrive.
+     */
+    void logpointOutput(const QStringList& lines);
+
     /**
      * This signal is emitted when the debugger recognizes that a specific
      * location in a file ought to be displayed.
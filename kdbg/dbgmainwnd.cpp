@@ -15,6 +15,7 @@
 #include <kaction.h>
 #include <kactioncollection.h>
 #include <krecentfilesaction.h>
+#include <kselectaction.h>
 #include <ktoggleaction.h>
 #include <kfiledialog.h>
 #include <kshortcutsdialog.h>
@@ -30,12 +31,18 @@
 #include <QList>
 #include <QDockWidget>
 #include <QProcess>
+#include <QStackedWidget>
+#include <QTreeView>
 #include "dbgmainwnd.h"
 #include "debugger.h"
 #include "commandids.h"
 #include "winstack.h"
 #include "brkpt.h"
+#include "exprmodel.h"
 #include "threadlist.h"
+#include "statwnd.h"
+#include "stackgroupwnd.h"
+#include "logpointwnd.h"
 #include "memwindow.h"
 #include "ttywnd.h"
 #include "watchwindow.h"
@@ -43,6 +50,7 @@
 #include "prefdebugger.h"
 #include "prefmisc.h"
 #include "gdbdriver.h"
+#include "gdbmidriver.h"
 #include "xsldbgdriver.h"
 #include "mydebug.h"
 #include <sys/stat.h>			/* mknod(2) */
@@ -59,10 +67,13 @@ DebuggerMainWnd::DebuggerMainWnd() :
 #ifdef GDB_TRANSCRIPT
 	m_transcriptFile(GDB_TRANSCRIPT),
 #endif
+	m_pipelineDepth(1),
+	m_arrayPageSize(DebuggerDriver::defaultArrayPageSize),
 	m_outputTermCmdStr(defaultTermCmdStr),
 	m_outputTermProc(new QProcess),
 	m_ttyLevel(-1),			/* no tty yet */
 	m_popForeground(false),
+	m_lightweightLocals(false),
 	m_backTimeout(1000),
 	m_tabWidth(0),
 	m_sourceFilter(defaultSourceFilter),
@@ -79,8 +90,16 @@ DebuggerMainWnd::DebuggerMainWnd() :
     m_btWindow = new QListWidget(dw1);
     dw1->setWidget(m_btWindow);
     QDockWidget* dw2 = createDockWidget("Locals", i18n("Locals"));
-    m_localVariables = new ExprWnd(dw2, i18n("Variable"));
-    dw2->setWidget(m_localVariables);
+    m_localsStack = new QStackedWidget(dw2);
+    m_localVariables = new ExprWnd(m_localsStack, i18n("Variable"));
+    m_localsModel = new ExprModel(i18n("Variable"), this);
+    m_localsView = new QTreeView(m_localsStack);
+    m_localsView->setUniformRowHeights(true);
+    m_localsView->setAllColumnsShowFocus(true);
+    m_localsView->setModel(m_localsModel);
+    m_localsStack->addWidget(m_localVariables);
+    m_localsStack->addWidget(m_localsView);
+    dw2->setWidget(m_localsStack);
     QDockWidget* dw3 = createDockWidget("Watches", i18n("Watches"));
     m_watches = new WatchWindow(dw3);
     dw3->setWidget(m_watches);
@@ -99,12 +118,24 @@ DebuggerMainWnd::DebuggerMainWnd() :
     QDockWidget* dw8 = createDockWidget("Memory", i18n("Memory"));
     m_memoryWindow = new MemoryWindow(dw8);
     dw8->setWidget(m_memoryWindow);
+    QDockWidget* dw9 = createDockWidget("Statistics", i18n("Statistics"));
+    m_statistics = new StatisticsWindow(dw9);
+    dw9->setWidget(m_statistics);
+    QDockWidget* dw10 = createDockWidget("ThreadStacks", i18n("Thread Stacks"));
+    m_stackGroups = new StackGroupWindow(dw10);
+    dw10->setWidget(m_stackGroups);
+    QDockWidget* dw11 = createDockWidget("Logpoints", i18n("Logpoints"));
+    m_logpoints = new LogpointWindow(dw11);
+    dw11->setWidget(m_logpoints);
 
     m_debugger = new KDebugger(this, m_localVariables, m_watches->watchVariables(), m_btWindow);
 
     connect(m_debugger, SIGNAL(updateStatusMessage()), SLOT(slotNewStatusMsg()));
     connect(m_debugger, SIGNAL(updateUI()), SLOT(updateUI()));
-    connect(m_debugger, SIGNAL(breakpointsChanged()), SLOT(updateLineItems()));
+    connect(m_debugger, SIGNAL(breakpointUpdated(const Breakpoint&)),
+	    SLOT(slotBreakpointUpdated(const Breakpoint&)));
+    connect(m_debugger, SIGNAL(breakpointRemoved(const Breakpoint&)),
+	    SLOT(slotBreakpointRemoved(const Breakpoint&)));
     connect(m_debugger, SIGNAL(debuggerStarting()), SLOT(slotDebuggerStarting()));
     m_bpTable->setDebugger(m_debugger);
     m_memoryWindow->setDebugger(m_debugger);
@@ -152,11 +183,23 @@ DebuggerMainWnd::DebuggerMainWnd() :
     connect(m_bpTable, SIGNAL(activateFileLine(const QString&,int,const DbgAddr&)),
 	    m_filesWindow, SLOT(activate(const QString&,int,const DbgAddr&)));
     connect(m_debugger, SIGNAL(updateUI()), m_bpTable, SLOT(updateUI()));
-    connect(m_debugger, SIGNAL(breakpointsChanged()), m_bpTable, SLOT(updateBreakList()));
+    connect(m_debugger, SIGNAL(breakpointUpdated(const Breakpoint&)),
+	    m_bpTable, SLOT(updateBreakpoint(const Breakpoint&)));
+    connect(m_debugger, SIGNAL(breakpointRemoved(const Breakpoint&)),
+	    m_bpTable, SLOT(removeBreakpoint(const Breakpoint&)));
     connect(m_debugger, SIGNAL(breakpointsChanged()), m_bpTable, SLOT(updateUI()));
+    connect(m_debugger, SIGNAL(breakpointRatesChanged()), m_bpTable, SLOT(updateRates()));
+    connect(m_debugger, SIGNAL(breakpointRatesChanged()), SLOT(slotBreakpointRatesChanged()));
 
     connect(m_debugger, SIGNAL(registersChanged(const std::list<RegisterInfo>&)),
 	    m_registers, SLOT(updateRegisters(const std::list<RegisterInfo>&)));
+    connect(m_debugger, SIGNAL(registerValuesChanged(const std::list<RegisterInfo>&)),
+	    m_registers, SLOT(updateRegisterValues(const std::list<RegisterInfo>&)));
+    connect(m_registers, SIGNAL(wantedRegistersChanged(const QStringList&)),
+	    m_debugger, SLOT(setWantedRegisters(const QStringList&)));
+    // registers are not requested while they are not visible
+    connect(dw4, SIGNAL(visibilityChanged(bool)),
+	    m_debugger, SLOT(setRegistersShown(bool)));
 
     connect(m_debugger, SIGNAL(memoryDumpChanged(const QString&, const std::list<MemoryDump>&)),
 	    m_memoryWindow, SLOT(slotNewMemoryDump(const QString&, const std::list<MemoryDump>&)));
@@ -171,6 +214,22 @@ DebuggerMainWnd::DebuggerMainWnd() :
     connect(m_threads, SIGNAL(setThread(int)),
 	    m_debugger, SLOT(setThread(int)));
 
+    // command statistics are refreshed when the debugger becomes idle
+    connect(m_debugger, SIGNAL(updateUI()), SLOT(slotUpdateStatistics()));
+    connect(dw9, SIGNAL(visibilityChanged(bool)), SLOT(slotUpdateStatistics()));
+
+    // the stacks of all threads are collected only while they are shown
+    connect(m_debugger, SIGNAL(threadStacksChanged(const std::list<ThreadStack>&)),
+	    m_stackGroups, SLOT(updateStacks(const std::list<ThreadStack>&)));
+    connect(m_stackGroups, SIGNAL(setThread(int)),
+	    m_debugger, SLOT(setThread(int)));
+    connect(m_debugger, SIGNAL(programStopped()), SLOT(slotUpdateThreadStacks()));
+    connect(dw10, SIGNAL(visibilityChanged(bool)), SLOT(slotUpdateThreadStacks()));
+
+    // logpoints print while the program runs
+    connect(m_debugger, SIGNAL(logpointOutput(const QStringList&)),
+	    m_logpoints, SLOT(appendLines(const QStringList&)));
+
     // popup menu of the local variables window
     m_localVariables->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(m_localVariables, SIGNAL(customContextMenuRequested(const QPoint&)),
@@ -195,13 +254,18 @@ DebuggerMainWnd::~DebuggerMainWnd()
     delete m_debugger;
     m_debugger = 0;
 
+    delete m_logpoints;
+    delete m_stackGroups;
+    delete m_statistics;
     delete m_memoryWindow;
     delete m_threads;
     delete m_ttyWindow;
     delete m_bpTable;
     delete m_registers;
     delete m_watches;
+    delete m_localsView;
     delete m_localVariables;
+    delete m_localsStack;
     delete m_btWindow;
     delete m_filesWindow;
 
@@ -261,6 +325,12 @@ void DebuggerMainWnd::initKAction()
     m_recentExecAction->setText(i18n("Recent E&xecutables"));
     m_coreDumpAction = createAction(i18n("&Core dump..."), 0,
 			this, SLOT(slotFileCore()), "file_core_dump");
+    createAction(i18n("&New Session"), "window-new", 0,
+			this, SLOT(slotFileNewSession()), "file_new_session");
+    m_sessionsAction = new KSelectAction(i18n("&Sessions"), actionCollection());
+    actionCollection()->addAction("file_sessions", m_sessionsAction);
+    connect(m_sessionsAction->menu(), SIGNAL(aboutToShow()), SLOT(slotUpdateSessions()));
+    connect(m_sessionsAction, SIGNAL(triggered(int)), SLOT(slotSwitchSession(int)));
     KStandardAction::quit(kapp, SLOT(closeAllWindows()), actionCollection());
 
     // settings menu
@@ -285,7 +355,10 @@ void DebuggerMainWnd::initKAction()
 	{ i18n("&Breakpoints"), m_bpTable, "view_breakpoints", &m_bpTableAction },
 	{ i18n("T&hreads"), m_threads, "view_threads", &m_threadsAction },
 	{ i18n("&Output"), m_ttyWindow, "view_output", &m_ttyWindowAction },
-	{ i18n("&Memory"), m_memoryWindow, "view_memory", &m_memoryWindowAction }
+	{ i18n("&Memory"), m_memoryWindow, "view_memory", &m_memoryWindowAction },
+	{ i18n("&Statistics"), m_statistics, "view_statistics", &m_statisticsAction },
+	{ i18n("Thread st&acks"), m_stackGroups, "view_thread_stacks", &m_stackGroupsAction },
+	{ i18n("Lo&gpoints"), m_logpoints, "view_logpoints", &m_logpointsAction }
     };
     for (unsigned i = 0; i < sizeof(dw)/sizeof(dw[0]); i++) {
 	QDockWidget* d = dockParent(dw[i].w);
@@ -418,8 +491,11 @@ static const char TermCmdStr[] = "TermCmdStr";
 static const char KeepScript[] = "KeepScript";
 static const char DebuggerGroup[] = "Debugger";
 static const char DebuggerCmdStr[] = "DebuggerCmdStr";
+static const char PipelineDepth[] = "PipelineDepth";
+static const char ArrayPageSize[] = "ArrayPageSize";
 static const char PreferencesGroup[] = "Preferences";
 static const char PopForeground[] = "PopForeground";
+static const char LightweightLocals[] = "LightweightLocals";
 static const char BackTimeout[] = "BackTimeout";
 static const char TabWidth[] = "TabWidth";
 static const char SourceFileFilter[] = "SourceFileFilter";
@@ -439,9 +515,12 @@ void DebuggerMainWnd::saveSettings(KSharedConfigPtr config)
 
     config->group(OutputWindowGroup).writeEntry(TermCmdStr, m_outputTermCmdStr);
     config->group(DebuggerGroup).writeEntry(DebuggerCmdStr, m_debuggerCmdStr);
+    config->group(DebuggerGroup).writeEntry(PipelineDepth, m_pipelineDepth);
+    config->group(DebuggerGroup).writeEntry(ArrayPageSize, m_arrayPageSize);
 
     KConfigGroup pg(config->group(PreferencesGroup));
     pg.writeEntry(PopForeground, m_popForeground);
+    pg.writeEntry(LightweightLocals, m_lightweightLocals);
     pg.writeEntry(BackTimeout, m_backTimeout);
     pg.writeEntry(TabWidth, m_tabWidth);
     pg.writeEntry(SourceFileFilter, m_sourceFilter);
@@ -475,9 +554,13 @@ void DebuggerMainWnd::restoreSettings(KSharedConfigPtr config)
     m_outputTermKeepScript = og.readEntry(KeepScript);
 
     setDebuggerCmdStr(config->group(DebuggerGroup).readEntry(DebuggerCmdStr));
+    m_pipelineDepth = config->group(DebuggerGroup).readEntry(PipelineDepth, 1);
+    m_arrayPageSize = config->group(DebuggerGroup).readEntry(ArrayPageSize,
+								  DebuggerDriver::defaultArrayPageSize);
 
     KConfigGroup pg(config->group(PreferencesGroup));
     m_popForeground = pg.readEntry(PopForeground, false);
+    setLightweightLocals(pg.readEntry(LightweightLocals, false));
     m_backTimeout = pg.readEntry(BackTimeout, 1000);
     m_tabWidth = pg.readEntry(TabWidth, 0);
     m_sourceFilter = pg.readEntry(SourceFileFilter, m_sourceFilter);
@@ -501,6 +584,9 @@ void DebuggerMainWnd::updateUI()
     m_threadsAction->setChecked(isDockVisible(m_threads));
     m_memoryWindowAction->setChecked(isDockVisible(m_memoryWindow));
     m_ttyWindowAction->setChecked(isDockVisible(m_ttyWindow));
+    m_statisticsAction->setChecked(isDockVisible(m_statistics));
+    m_stackGroupsAction->setChecked(isDockVisible(m_stackGroups));
+    m_logpointsAction->setChecked(isDockVisible(m_logpoints));
 
     m_fileExecAction->setEnabled(m_debugger->isIdle());
     m_settingsAction->setEnabled(m_debugger->haveExecutable());
@@ -550,6 +636,21 @@ void DebuggerMainWnd::updateLineItems()
     m_filesWindow->updateLineItems(m_debugger);
 }
 
+void DebuggerMainWnd::slotBreakpointUpdated(const Breakpoint& bp)
+{
+    m_filesWindow->updateBreakpoint(bp);
+}
+
+void DebuggerMainWnd::slotBreakpointRemoved(const Breakpoint& bp)
+{
+    m_filesWindow->removeBreakpoint(m_debugger, bp);
+}
+
+void DebuggerMainWnd::slotBreakpointRatesChanged()
+{
+    m_filesWindow->updateBreakpointRates(m_debugger);
+}
+
 void DebuggerMainWnd::slotAddWatch()
 {
     if (m_debugger != 0) {
@@ -605,6 +706,9 @@ void DebuggerMainWnd::makeDefaultLayout()
     tabifyDockWidget(dockParent(m_bpTable), dockParent(m_ttyWindow));
     tabifyDockWidget(dockParent(m_ttyWindow), dockParent(m_btWindow));
     tabifyDockWidget(dockParent(m_threads), dockParent(m_watches));
+    tabifyDockWidget(dockParent(m_watches), dockParent(m_statistics));
+    tabifyDockWidget(dockParent(m_statistics), dockParent(m_stackGroups));
+    tabifyDockWidget(dockParent(m_ttyWindow), dockParent(m_logpoints));
     dockParent(m_localVariables)->setVisible(true);
     dockParent(m_ttyWindow)->setVisible(true);
     dockParent(m_watches)->setVisible(true);
@@ -694,6 +798,8 @@ bool DebuggerMainWnd::startDriver(const QString& executable, QString lang)
     }
 
     driver->setLogFileName(m_transcriptFile);
+    driver->setPipelineDepth(m_pipelineDepth);
+    driver->setArrayPageSize(m_arrayPageSize);
 
     bool success = m_debugger->debugProgram(executable, driver);
 
@@ -727,6 +833,7 @@ DebuggerDriver* DebuggerMainWnd::driverFromLang(QString lang)
 	{ "x",       "xslt",    2 },
 	// the following are actually driver names
 	{ "gdb",     "gdb",     1 },
+	{ "gdbm",    "gdbmi",   4 },
 	{ "xsldbg",  "xsldbg",  2 },
     };
     const int N = sizeof(langs)/sizeof(langs[0]);
@@ -760,6 +867,13 @@ DebuggerDriver* DebuggerMainWnd::driverFromLang(QString lang)
     case 2:
 	driver = new XsldbgDriver;
 	break;
+    case 4:
+	{
+	    GdbMIDriver* gdb = new GdbMIDriver;
+	    gdb->setDefaultInvocation(m_debuggerCmdStr);
+	    driver = gdb;
+	}
+	break;
     default:
 	// unknown language
 	break;
@@ -792,6 +906,13 @@ void DebuggerMainWnd::setRemoteDevice(const QString& remoteDevice)
     }
 }
 
+void DebuggerMainWnd::setRunGdbserver(bool run)
+{
+    if (m_debugger != 0) {
+	m_debugger->setRunGdbserver(run);
+    }
+}
+
 void DebuggerMainWnd::overrideProgramArguments(const QString& args)
 {
     assert(m_debugger != 0);
@@ -830,9 +951,12 @@ void DebuggerMainWnd::slotFileGlobalSettings()
     prefDebugger.setDebuggerCmd(m_debuggerCmdStr.isEmpty()  ?
 				GdbDriver::defaultGdb()  :  m_debuggerCmdStr);
     prefDebugger.setTerminal(m_outputTermCmdStr);
+    prefDebugger.setPipelineDepth(m_pipelineDepth);
+    prefDebugger.setArrayPageSize(m_arrayPageSize);
 
     PrefMisc prefMisc(&dlg);
     prefMisc.setPopIntoForeground(m_popForeground);
+    prefMisc.setLightweightLocals(m_lightweightLocals);
     prefMisc.setBackTimeout(m_backTimeout);
     prefMisc.setTabWidth(m_tabWidth);
     prefMisc.setSourceFilter(m_sourceFilter);
@@ -844,7 +968,10 @@ void DebuggerMainWnd::slotFileGlobalSettings()
     {
 	setDebuggerCmdStr(prefDebugger.debuggerCmd());
 	setTerminalCmd(prefDebugger.terminal());
+	m_pipelineDepth = qMax(prefDebugger.pipelineDepth(), 1);
+	m_arrayPageSize = qMax(prefDebugger.arrayPageSize(), 0);
 	m_popForeground = prefMisc.popIntoForeground();
+	setLightweightLocals(prefMisc.lightweightLocals());
 	m_backTimeout = prefMisc.backTimeout();
 	m_tabWidth = prefMisc.tabWidth();
 	m_sourceFilter = prefMisc.sourceFilter();
@@ -860,6 +987,22 @@ void DebuggerMainWnd::slotFileGlobalSettings()
     }
 }
 
+/*
+ * Switches the Locals window between the ExprWnd and the read-only view
+ * of the ExprModel, which copes better with very large variables.
+ */
+void DebuggerMainWnd::setLightweightLocals(bool on)
+{
+    m_lightweightLocals = on;
+    if (on) {
+	m_localsStack->setCurrentWidget(m_localsView);
+	m_debugger->setLocalsModel(m_localsModel);
+    } else {
+	m_localsStack->setCurrentWidget(m_localVariables);
+	m_debugger->setLocalsModel(0);
+    }
+}
+
 void DebuggerMainWnd::setTerminalCmd(const QString& cmd)
 {
     m_outputTermCmdStr = cmd;
@@ -878,6 +1021,22 @@ void DebuggerMainWnd::setDebuggerCmdStr(const QString& cmd)
     }
 }
 
+void DebuggerMainWnd::slotUpdateStatistics()
+{
+    if (m_debugger == 0 || m_debugger->driver() == 0)
+	return;
+    if (!isDockVisible(m_statistics))
+	return;
+    m_statistics->updateStatistics(m_debugger->driver()->statistics());
+}
+
+void DebuggerMainWnd::slotUpdateThreadStacks()
+{
+    if (m_debugger == 0 || !isDockVisible(m_stackGroups))
+	return;
+    m_debugger->collectThreadStacks();
+}
+
 void DebuggerMainWnd::slotDebuggerStarting()
 {
     if (m_debugger == 0)		/* paranoia check */
@@ -1175,6 +1334,45 @@ void DebuggerMainWnd::slotFileOpen()
     }
 }
 
+/*
+ * Each session is a main window of its own, with its own debugger
+ * process. The transcript of the new session goes to a separate file.
+ */
+void DebuggerMainWnd::slotFileNewSession()
+{
+    DebuggerMainWnd* wnd = new DebuggerMainWnd;
+    if (!m_transcriptFile.isEmpty()) {
+	wnd->setTranscript(m_transcriptFile + "." +
+			   QString::number(KMainWindow::memberList().size()));
+    }
+    wnd->show();
+}
+
+void DebuggerMainWnd::slotUpdateSessions()
+{
+    QStringList names;
+    int current = -1;
+    QList<KMainWindow*> windows = KMainWindow::memberList();
+    for (int i = 0; i < windows.size(); i++) {
+	names.append(windows[i]->windowTitle());
+	if (windows[i] == this)
+	    current = i;
+    }
+    m_sessionsAction->setItems(names);
+    m_sessionsAction->setCurrentItem(current);
+}
+
+void DebuggerMainWnd::slotSwitchSession(int index)
+{
+    QList<KMainWindow*> windows = KMainWindow::memberList();
+    if (index < 0 || index >= windows.size())
+	return;
+    KMainWindow* wnd = windows[index];
+    wnd->show();
+    wnd->raise();
+    KWindowSystem::forceActiveWindow(wnd->winId());
+}
+
 void DebuggerMainWnd::slotFileExe()
 {
     if (m_debugger->isIdle())
@@ -13,20 +13,28 @@
 
 class QDockWidget;
 class QProcess;
+class QStackedWidget;
+class QTreeView;
 class KAnimatedButton;
 class KRecentFilesAction;
+class KSelectAction;
 class KUrl;
 class WinStack;
 class QListWidget;
 class ExprWnd;
+class ExprModel;
 class BreakpointTable;
 class ThreadList;
+class StatisticsWindow;
+class StackGroupWindow;
+class LogpointWindow;
 class MemoryWindow;
 class TTYWindow;
 class WatchWindow;
 class KDebugger;
 class DebuggerDriver;
 struct DbgAddr;
+struct Breakpoint;
 
 class DebuggerMainWnd : public KXmlGuiWindow
 {
@@ -49,6 +57,7 @@ public:
     // the following are needed to handle program arguments
     void setCoreFile(const QString& corefile);
     void setRemoteDevice(const QString &remoteDevice);
+    void setRunGdbserver(bool run);
     void overrideProgramArguments(const QString& args);
 
 protected:
@@ -67,12 +76,18 @@ protected:
     WinStack* m_filesWindow;
     QListWidget* m_btWindow;
     ExprWnd* m_localVariables;
+    ExprModel* m_localsModel;		/* for the lightweight Locals view */
+    QTreeView* m_localsView;
+    QStackedWidget* m_localsStack;	/* shows one of the above */
     WatchWindow* m_watches;
     RegisterView* m_registers;
     BreakpointTable* m_bpTable;
     TTYWindow* m_ttyWindow;
     ThreadList* m_threads;
     MemoryWindow* m_memoryWindow;
+    StatisticsWindow* m_statistics;
+    StackGroupWindow* m_stackGroups;
+    LogpointWindow* m_logpoints;
 
     QTimer m_backTimer;
 
@@ -81,6 +96,7 @@ protected:
     QAction* m_reloadAction;
     QAction* m_fileExecAction;
     KRecentFilesAction* m_recentExecAction;
+    KSelectAction* m_sessionsAction;
     QAction* m_coreDumpAction;
     QAction* m_settingsAction;
     QAction* m_findAction;
@@ -92,6 +108,9 @@ protected:
     QAction* m_ttyWindowAction;
     QAction* m_threadsAction;
     QAction* m_memoryWindowAction;
+    QAction* m_statisticsAction;
+    QAction* m_stackGroupsAction;
+    QAction* m_logpointsAction;
     QAction* m_runAction;
     QAction* m_stepIntoAction;
     QAction* m_stepOverAction;
@@ -124,6 +143,8 @@ protected:
     QString m_debuggerCmdStr;
     KDebugger* m_debugger;
     QString m_transcriptFile;		/* where gdb dialog is logged */
+    int m_pipelineDepth;		/* commands in flight */
+    int m_arrayPageSize;		/* array elements printed at once */
 
     /**
      * Starts to debug the specified program using the specified language
@@ -145,11 +166,13 @@ protected:
     QString createOutputWindow();
 
     bool m_popForeground;		/* whether main wnd raises when prog stops */
+    bool m_lightweightLocals;		/* whether locals are shown by m_localsView */
     int m_backTimeout;			/* when wnd goes back */
     int m_tabWidth;			/* tab width in characters (can be 0) */
     QString m_sourceFilter;
     QString m_headerFilter;
     void setTerminalCmd(const QString& cmd);
+    void setLightweightLocals(bool on);
     void setDebuggerCmdStr(const QString& cmd);
 
     QDockWidget* createDockWidget(const char* name, const QString& title);
@@ -174,11 +197,16 @@ signals:
 public slots:
     virtual void updateUI();
     virtual void updateLineItems();
+    void slotBreakpointUpdated(const Breakpoint& bp);
+    void slotBreakpointRemoved(const Breakpoint& bp);
+    void slotBreakpointRatesChanged();
     void slotAddWatch();
     void slotAddWatch(const QString& text);
     void slotNewFileLoaded();
     void slotNewStatusMsg();
     void slotDebuggerStarting();
+    void slotUpdateStatistics();
+    void slotUpdateThreadStacks();
     void slotToggleBreak(const QString&, int, const DbgAddr&, bool);
     void slotEnaDisBreak(const QString&, int, const DbgAddr&);
     void slotProgramStopped();
@@ -189,6 +217,9 @@ public slots:
     void slotEditValue();
 
     void slotFileOpen();
+    void slotFileNewSession();
+    void slotUpdateSessions();
+    void slotSwitchSession(int index);
     void slotFileExe();
     void slotFileCore();
     void slotFileGlobalSettings();
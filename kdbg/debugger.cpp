@@ -9,12 +9,17 @@
 #include "pgmargs.h"
 #include "typetable.h"
 #include "exprwnd.h"
+#include "exprmodel.h"
 #include "pgmsettings.h"
+#include <QDateTime>
+#include <QHash>
 #include <QFileInfo>
 #include <QListWidget>
+#include <QScrollBar>
 #include <QApplication>
 #include <kcodecs.h>			// KMD5
 #include <kconfig.h>
+#include <kshell.h>
 #include <klocale.h>			/* i18n */
 #include <kmessagebox.h>
 #include <kstandarddirs.h>
@@ -62,14 +67,30 @@ KDebugger::KDebugger(QWidget* parent,
 	QObject(parent),
 	m_ttyLevel(ttyFull),
 	m_memoryFormat(MDTword | MDThex),
+	m_minOrphanId(0),
 	m_haveExecutable(false),
 	m_programActive(false),
 	m_programRunning(false),
+	m_runGdbserver(false),
 	m_sharedLibsListed(false),
 	m_typeTable(0),
+	m_curFrame(0),
+	m_btFrames(btWindowSize),
+	m_btMore(false),
+	m_btGeneration(-1),
+	m_btCheckLevel(-1),
+	m_localsFrame(-1),
+	m_localsGeneration(-1),
+	m_frameLocalsGeneration(-1),
+	m_threadStacksGeneration(-1),
+	m_registersListed(false),
+	m_registersShown(false),
+	m_registersStale(false),
+	m_runningMs(0),
 	m_programConfig(0),
 	m_d(0),
 	m_localVariables(*localVars),
+	m_localsModel(0),
 	m_watchVariables(*watchVars),
 	m_btWindow(*backtrace)
 {
@@ -81,8 +102,14 @@ KDebugger::KDebugger(QWidget* parent,
 	    SLOT(slotValueEdited(VarTree*, const QString&)));
     connect(&m_watchVariables, SIGNAL(editValueCommitted(VarTree*, const QString&)),
 	    SLOT(slotValueEdited(VarTree*, const QString&)));
+    connect(&m_localVariables, SIGNAL(viewportChanged()), SLOT(slotViewportChanged()));
+    connect(this, SIGNAL(localsChanged(const QStringList&, const QStringList&, const QStringList&)),
+	    &m_localVariables, SLOT(slotExprsChanged(const QStringList&, const QStringList&, const QStringList&)));
+    connect(&m_watchVariables, SIGNAL(viewportChanged()), SLOT(slotViewportChanged()));
 
     connect(&m_btWindow, SIGNAL(currentRowChanged(int)), this, SLOT(gotoFrame(int)));
+    connect(m_btWindow.verticalScrollBar(), SIGNAL(valueChanged(int)),
+	    SLOT(slotBacktraceScrolled(int)));
 
     emit updateUI();
 }
@@ -95,6 +122,8 @@ KDebugger::~KDebugger()
 	delete m_programConfig;
     }
 
+    clearFrameLocals();
+    discardOldFrames();
     delete m_typeTable;
 }
 
@@ -145,6 +174,8 @@ bool KDebugger::debugProgram(const QString& name,
 	    SLOT(parse(CmdQueueItem*,const char*)));
     connect(driver, SIGNAL(bytesWritten(qint64)), SIGNAL(updateUI()));
     connect(driver, SIGNAL(inferiorRunning()), SLOT(slotInferiorRunning()));
+    connect(driver, SIGNAL(logpointOutput(const QStringList&)),
+	    SIGNAL(logpointOutput(const QStringList&)));
     connect(driver, SIGNAL(enterIdleState()), SLOT(backgroundUpdate()));
     connect(driver, SIGNAL(enterIdleState()), SIGNAL(updateUI()));
     connect(&m_localVariables, SIGNAL(removingItem(VarTree*)),
@@ -178,23 +209,49 @@ bool KDebugger::debugProgram(const QString& name,
 
     // set remote target
     if (!m_remoteDevice.isEmpty()) {
-	m_d->executeCmd(DCtargetremote, m_remoteDevice);
-	m_d->queueCmd(DCbt, DebuggerDriver::QMoverride);
-	m_d->queueCmd(DCinfothreads, DebuggerDriver::QMoverride);
-	m_d->queueCmd(DCframe, 0, DebuggerDriver::QMnormal);
-	m_programActive = true;
-	m_haveExecutable = true;
+	connectRemote(m_remoteDevice);
     }
 
     // create a type table
     m_typeTable = new ProgramTypeTable;
     m_sharedLibsListed = false;
+    m_registersListed = false;
 
     emit updateUI();
 
     return true;
 }
 
+/*
+ * Breakpoint conditions are evaluated by the remote stub if it can do so;
+ * otherwise, gdb falls back to evaluate them itself.
+ */
+void KDebugger::connectRemote(const QString& device)
+{
+    m_d->executeCmd(DCtargetcond);
+    m_d->executeCmd(DCtargetremote, device);
+    queueBacktrace();
+    m_d->queueCmd(DCinfothreads, DebuggerDriver::QMoverride);
+    m_d->queueCmd(DCframe, 0, DebuggerDriver::QMnormal);
+    m_programActive = true;
+    m_haveExecutable = true;
+}
+
+/*
+ * gdb starts the gdbserver and talks to it through a pipe. This happens
+ * only after the program settings were restored, so that the program
+ * receives its arguments. The gdbserver evaluates the conditions of
+ * breakpoints, and the program is not stopped for each hit whose
+ * condition is false.
+ */
+void KDebugger::startGdbserver()
+{
+    QString device = "| gdbserver - " + KShell::quoteArg(m_executable);
+    if (!m_programArgs.isEmpty())
+	device += " " + m_programArgs;
+    connectRemote(device);
+}
+
 void KDebugger::shutdown()
 {
     // shut down debugger driver
@@ -412,44 +469,95 @@ void KDebugger::setBreakpoint(Breakpoint* bp, bool queueOnly)
     cmd->m_brkpt = bp;	// used in newBreakpoint()
 }
 
-CmdQueueItem* KDebugger::executeBreakpoint(const Breakpoint* bp, bool queueOnly)
+/*
+ * Determines the command that sets the breakpoint and its arguments.
+ */
+static DbgCommand breakpointCommand(const Breakpoint* bp, QString& strArg, int& intArg)
 {
-    CmdQueueItem* cmd;
-    if (!bp->text.isEmpty())
+    intArg = 0;
+    if (bp->type == Breakpoint::logpoint)
+    {
+	// the location, the format, and its arguments as dprintf takes them
+	strArg = bp->text;
+	return DClogpoint;
+    }
+    else if (!bp->text.isEmpty())
     {
 	/*
 	 * The breakpoint was set using the text box in the breakpoint
 	 * list. This is the only way in which watchpoints are set.
 	 */
-	if (bp->type == Breakpoint::watchpoint) {
-	    cmd = m_d->executeCmd(DCwatchpoint, bp->text);
-	} else {
-	    cmd = m_d->executeCmd(DCbreaktext, bp->text);
-	}
+	strArg = bp->text;
+	return bp->type == Breakpoint::watchpoint ? DCwatchpoint : DCbreaktext;
     }
     else if (bp->address.isEmpty())
     {
 	// strip off directory part of file name
-	QString file = QFileInfo(bp->fileName).fileName();
-	if (queueOnly) {
-	    cmd = m_d->queueCmd(bp->temporary ? DCtbreakline : DCbreakline,
-				file, bp->lineNo, DebuggerDriver::QMoverride);
-	} else {
-	    cmd = m_d->executeCmd(bp->temporary ? DCtbreakline : DCbreakline,
-				  file, bp->lineNo);
-	}
+	strArg = QFileInfo(bp->fileName).fileName();
+	intArg = bp->lineNo;
+	return bp->temporary ? DCtbreakline : DCbreakline;
     }
     else
     {
-	if (queueOnly) {
-	    cmd = m_d->queueCmd(bp->temporary ? DCtbreakaddr : DCbreakaddr,
-				bp->address.asString(), DebuggerDriver::QMoverride);
-	} else {
-	    cmd = m_d->executeCmd(bp->temporary ? DCtbreakaddr : DCbreakaddr,
-				  bp->address.asString());
+	strArg = bp->address.asString();
+	return bp->temporary ? DCtbreakaddr : DCbreakaddr;
+    }
+}
+
+CmdQueueItem* KDebugger::executeBreakpoint(const Breakpoint* bp, bool queueOnly)
+{
+    QString strArg;
+    int intArg;
+    DbgCommand dc = breakpointCommand(bp, strArg, intArg);
+    switch (dc) {
+    case DCwatchpoint:
+    case DCbreaktext:
+    case DClogpoint:
+	return m_d->executeCmd(dc, strArg);
+    case DCbreakline:
+    case DCtbreakline:
+	if (queueOnly)
+	    return m_d->queueCmd(dc, strArg, intArg, DebuggerDriver::QMoverride);
+	return m_d->executeCmd(dc, strArg, intArg);
+    default:
+	if (queueOnly)
+	    return m_d->queueCmd(dc, strArg, DebuggerDriver::QMoverride);
+	return m_d->executeCmd(dc, strArg);
+    }
+}
+
+void KDebugger::setBreakpoints(const std::list<BrkptBatchItem>& items, bool queueOnly)
+{
+    if (items.empty())
+	return;
+
+    std::list<BrkptBatchItem>::const_iterator i;
+    if (items.size() == 1 || !m_d->canBatchBreakpoints())
+    {
+	for (i = items.begin(); i != items.end(); ++i) {
+	    const Breakpoint* bp = i->m_brkpt;
+	    if (bp == 0)
+		bp = &*breakpointById(i->m_existingBrkpt);
+	    CmdQueueItem* cmd = executeBreakpoint(bp, queueOnly);
+	    cmd->m_brkpt = i->m_brkpt;		// used in newBreakpoint()
+	    cmd->m_existingBrkpt = i->m_existingBrkpt;
 	}
+	return;
+    }
+
+    // one line per breakpoint; handleBreakBatch() takes the output apart
+    QString lines;
+    for (i = items.begin(); i != items.end(); ++i) {
+	const Breakpoint* bp = i->m_brkpt;
+	if (bp == 0)
+	    bp = &*breakpointById(i->m_existingBrkpt);
+	QString strArg;
+	int intArg;
+	DbgCommand dc = breakpointCommand(bp, strArg, intArg);
+	lines += m_d->commandString(dc, strArg, intArg);
     }
-    return cmd;
+    CmdQueueItem* cmd = m_d->executeBreakBatch(lines, queueOnly);
+    cmd->m_brkptBatch = items;
 }
 
 bool KDebugger::infoLine(QString file, int lineNo, const DbgAddr& addr)
@@ -488,6 +596,7 @@ bool KDebugger::enableDisableBreakpoint(BrkptIterator bp)
 	m_d->executeCmd(bp->enabled ? DCdisable : DCenable, bp->id);
     } else {
 	bp->enabled = !bp->enabled;
+	emit breakpointUpdated(*bp);
 	emit breakpointsChanged();
     }
     return true;
@@ -531,6 +640,7 @@ bool KDebugger::conditionalBreakpoint(BrkptIterator bp,
     } else {
 	bp->condition = condition;
 	bp->ignoreCount = ignoreCount;
+	emit breakpointUpdated(*bp);
 	emit breakpointsChanged();
     }
     return true;
@@ -553,7 +663,10 @@ bool KDebugger::deleteBreakpoint(BrkptIterator bp)
 	}
 	m_d->executeCmd(DCdelete, bp->id);
     } else {
+	Breakpoint old = *bp;
+	unindexBreakpoint(bp);
 	m_brkpts.erase(bp);
+	emit breakpointRemoved(old);
 	emit breakpointsChanged();
     }
     return false;
@@ -674,6 +787,16 @@ void KDebugger::gdbExited()
     // erase types
     delete m_typeTable;
     m_typeTable = 0;
+    m_typeCache.clear();
+    m_curScope = QString();
+    clearFrameLocals();
+    m_localsGeneration = -1;
+    m_threadStacksGeneration = -1;
+    m_registersListed = false;
+    m_sessionClock.invalidate();
+    m_runClock.invalidate();
+    m_runningMs = 0;
+    m_brkptSince.clear();
 
     if (m_explicitKill) {
 	TRACE(m_d->driverName() + " exited normally");
@@ -692,7 +815,7 @@ void KDebugger::gdbExited()
     m_debuggerCmd = QString();		/* use global setting at next start! */
     m_attachedPid = QString();		/* we are no longer attached to a process */
     m_ttyLevel = ttyFull;
-    m_brkpts.clear();
+    removeAllBreakpoints();
 
     // erase PC
     emit updatePC(QString(), -1, DbgAddr(), 0);
@@ -739,6 +862,10 @@ const char OptionsSelected[] = "OptionsSelected";
 const char Variable[] = "Var%d";
 const char Value[] = "Value%d";
 const char ExprFmt[] = "Expr%d";
+const char TypeCacheGroup[] = "TypeCache";
+const char ExecutableTime[] = "ExecutableTime";
+const char TypeFmt[] = "Type%d";
+static const int maxTypeCache = 5000;
 
 void KDebugger::saveProgramSettings()
 {
@@ -770,6 +897,7 @@ void KDebugger::saveProgramSettings()
     }
 
     saveBreakpoints(m_programConfig);
+    saveTypeCache(m_programConfig);
 
     // watch expressions
     // first get rid of whatever was in this group
@@ -834,6 +962,7 @@ void KDebugger::restoreProgramSettings()
     updateProgEnvironment(pgmArgs, pgmWd, pgmVars, boolOptions);
 
     restoreBreakpoints(m_programConfig);
+    restoreTypeCache(m_programConfig);
 
     // watch expressions
     KConfigGroup wg = m_programConfig->group(WatchGroup);
@@ -856,6 +985,56 @@ void KDebugger::restoreProgramSettings()
     emit restoreProgramSpecific(m_programConfig);
 }
 
+/*
+ * The type cache is only valid for the same build of the executable. It
+ * is stored together with the modification time of the executable.
+ */
+void KDebugger::saveTypeCache(KConfig* config)
+{
+    config->deleteGroup(TypeCacheGroup);
+    if (m_typeCache.empty())
+	return;
+    KConfigGroup g = config->group(TypeCacheGroup);
+    g.writeEntry(ExecutableTime, QFileInfo(m_executable).lastModified());
+    QString exprName;
+    QString typeName;
+    int i = 0;
+    for (std::map<QString,QString>::iterator it = m_typeCache.begin();
+	 it != m_typeCache.end() && i < maxTypeCache; ++it, ++i)
+    {
+	exprName.sprintf(ExprFmt, i);
+	typeName.sprintf(TypeFmt, i);
+	g.writeEntry(exprName, it->first);
+	g.writeEntry(typeName, it->second);
+    }
+}
+
+void KDebugger::restoreTypeCache(KConfig* config)
+{
+    m_typeCache.clear();
+    KConfigGroup g = config->group(TypeCacheGroup);
+    QDateTime saved = g.readEntry(ExecutableTime, QDateTime());
+    if (!saved.isValid() || saved != QFileInfo(m_executable).lastModified()) {
+	TRACE("type cache is stale");
+	return;
+    }
+    QString exprName;
+    QString typeName;
+    for (int i = 0;; ++i) {
+	exprName.sprintf(ExprFmt, i);
+	typeName.sprintf(TypeFmt, i);
+	if (!g.hasKey(exprName)) {
+	    /* entry not present, assume that we've hit them all */
+	    break;
+	}
+	QString key = g.readEntry(exprName, QString());
+	// older versions did not record the file in the key
+	if (key.count('\n') < 2)
+	    continue;
+	m_typeCache[key] = g.readEntry(typeName, QString());
+    }
+}
+
 /**
  * Reads the debugger command line from the program settings. The config
  * group must have been set by the caller.
@@ -894,6 +1073,7 @@ const char Address[] = "Address";
 const char Temporary[] = "Temporary";
 const char Enabled[] = "Enabled";
 const char Condition[] = "Condition";
+const char Logpoint[] = "Logpoint";
 
 void KDebugger::saveBreakpoints(KConfig* config)
 {
@@ -927,6 +1107,8 @@ void KDebugger::saveBreakpoints(KConfig* config)
 	} else {
 	    g.writeEntry(Address, bp->address.asString());
 	}
+	if (bp->type == Breakpoint::logpoint)
+	    g.writeEntry(Logpoint, true);
 	g.writeEntry(Temporary, bp->temporary);
 	g.writeEntry(Enabled, bp->enabled);
 	if (!bp->condition.isEmpty())
@@ -948,6 +1130,7 @@ void KDebugger::saveBreakpoints(KConfig* config)
 void KDebugger::restoreBreakpoints(KConfig* config)
 {
     QString groupName;
+    std::list<BrkptBatchItem> items;
     /*
      * We recognize the end of the list if there is no Enabled entry
      * present.
@@ -972,17 +1155,19 @@ void KDebugger::restoreBreakpoints(KConfig* config)
 	    delete bp;
 	    continue;
 	}
+	if (g.readEntry(Logpoint, false) && !bp->text.isEmpty())
+	    bp->type = Breakpoint::logpoint;
 	bp->enabled = g.readEntry(Enabled, true);
 	bp->temporary = g.readEntry(Temporary, false);
 	bp->condition = g.readEntry(Condition);
 
 	/*
-	 * Add the breakpoint.
+	 * Add the breakpoint. The new breakpoint is disabled or
+	 * conditionalized later in newBreakpoint().
 	 */
-	setBreakpoint(bp, false);
-	// the new breakpoint is disabled or conditionalized later
-	// in newBreakpoint()
+	items.push_back(BrkptBatchItem(bp, 0));
     }
+    setBreakpoints(items, false);
     m_d->queueCmd(DCinfobreak, DebuggerDriver::QMoverride);
 }
 
@@ -996,6 +1181,7 @@ void KDebugger::parse(CmdQueueItem* cmd, const char* output)
 
     switch (cmd->m_cmd) {
     case DCtargetremote:
+    case DCtargetcond:
 	// the output (if any) is uninteresting
     case DCsetargs:
     case DCtty:
@@ -1035,6 +1221,10 @@ void KDebugger::parse(CmdQueueItem* cmd, const char* output)
 	    {
 		// handled elsewhere
 	    }
+	    else if (m_runGdbserver)
+	    {
+		startGdbserver();
+	    }
 	    else
 	    {
 		m_d->queueCmd(DCinfolinemain, DebuggerDriver::QMnormal);
@@ -1079,9 +1269,15 @@ void KDebugger::parse(CmdQueueItem* cmd, const char* output)
 	    handleLocals(output);
 	}
 	break;
+    case DCframelocals:
+	handleFrameLocals(cmd, output);
+	break;
     case DCinforegisters:
 	handleRegisters(output);
 	break;
+    case DCregistervalues:
+	emit registerValuesChanged(m_d->parseRegisters(output));
+	break;
     case DCexamine:
 	handleMemoryDump(output);
 	break;
@@ -1096,8 +1292,9 @@ void KDebugger::parse(CmdQueueItem* cmd, const char* output)
 	updateAllExprs();
 	break;
     case DCbt:
-	handleBacktrace(output);
-	updateAllExprs();
+    case DCbtrange:
+	if (handleBacktrace(cmd, output))
+	    updateAllExprs();
 	break;
     case DCprint:
 	handlePrint(cmd, output);
@@ -1133,7 +1330,8 @@ void KDebugger::parse(CmdQueueItem* cmd, const char* output)
     case DCbreakaddr:
     case DCtbreakaddr:
     case DCwatchpoint:
-	newBreakpoint(cmd, output);
+    case DClogpoint:
+	newBreakpoint(cmd->m_brkpt, cmd->m_existingBrkpt, output);
 	// fall through
     case DCdelete:
     case DCenable:
@@ -1141,6 +1339,10 @@ void KDebugger::parse(CmdQueueItem* cmd, const char* output)
 	// these commands need immediate response
 	m_d->queueCmd(DCinfobreak, DebuggerDriver::QMoverrideMoreEqual);
 	break;
+    case DCbreakbatch:
+	handleBreakBatch(cmd, output);
+	m_d->queueCmd(DCinfobreak, DebuggerDriver::QMoverrideMoreEqual);
+	break;
     case DCinfobreak:
 	// note: this handler must not enqueue a command, since
 	// DCinfobreak is used at various different places.
@@ -1154,6 +1356,12 @@ void KDebugger::parse(CmdQueueItem* cmd, const char* output)
     case DCprintWChar:
 	handlePrintStruct(cmd, output);
 	break;
+    case DCprintStructBatch:
+	handlePrintStructBatch(cmd, output);
+	break;
+    case DCprintPage:
+	handlePrintPage(cmd, output);
+	break;
     case DCinfosharedlib:
 	handleSharedLibs(output);
 	break;
@@ -1164,6 +1372,9 @@ void KDebugger::parse(CmdQueueItem* cmd, const char* output)
     case DCinfothreads:
 	handleThreadList(output);
 	break;
+    case DCbtall:
+	handleThreadStacks(output);
+	break;
     case DCsetpc:
 	handleSetPC(output);
 	break;
@@ -1177,13 +1388,23 @@ void KDebugger::backgroundUpdate()
 {
     /*
      * If there are still expressions that need to be updated, then do so.
+     * If there is nothing else to do, look ahead at the callers.
      */
-    if (m_programActive)
+    if (m_programActive) {
 	evalExpressions();
+	if (m_d->isIdle())
+	    prefetchLocals();
+    }
 }
 
 void KDebugger::handleRunCommands(const char* output)
 {
+    // the program has stopped; the hit rates refer to the running time
+    if (m_runClock.isValid()) {
+	m_runningMs += m_runClock.elapsed();
+	m_runClock.invalidate();
+    }
+
     uint flags = m_d->parseProgramStopped(output, m_statusMessage);
     emit updateStatusMessage();
 
@@ -1192,22 +1413,25 @@ void KDebugger::handleRunCommands(const char* output)
     // refresh files if necessary
     if (flags & DebuggerDriver::SFrefreshSource) {
 	TRACE("re-reading files");
+	// the types may have changed along with the executable
+	m_typeCache.clear();
 	emit executableUpdated();
     }
 
     /* 
      * Try to set any orphaned breakpoints now.
      */
+    std::list<BrkptBatchItem> orphans;
     for (BrkptIterator bp = m_brkpts.begin(); bp != m_brkpts.end(); ++bp)
     {
 	if (bp->isOrphaned()) {
 	    TRACE(QString("re-trying brkpt loc: %2 file: %3 line: %1")
 		    .arg(bp->lineNo).arg(bp->location, bp->fileName));
-	    CmdQueueItem* cmd = executeBreakpoint(&*bp, true);
-	    cmd->m_existingBrkpt = bp->id;	// used in newBreakpoint()
+	    orphans.push_back(BrkptBatchItem(0, bp->id));
 	    flags |= DebuggerDriver::SFrefreshBreak;
 	}
     }
+    setBreakpoints(orphans, true);
 
     /*
      * If we stopped at a breakpoint, we must update the breakpoint list
@@ -1232,7 +1456,7 @@ void KDebugger::handleRunCommands(const char* output)
 
     // get the backtrace if the program is running
     if (m_programActive) {
-	m_d->queueCmd(DCbt, DebuggerDriver::QMoverride);
+	queueBacktrace();
     } else {
 	// program finished: erase PC
 	emit updatePC(QString(), -1, DbgAddr(), 0);
@@ -1252,6 +1476,24 @@ void KDebugger::handleRunCommands(const char* output)
 void KDebugger::slotInferiorRunning()
 {
     m_programRunning = true;
+    if (!m_sessionClock.isValid())
+	m_sessionClock.start();
+    m_runClock.start();
+}
+
+qint64 KDebugger::runningTime() const
+{
+    qint64 ms = m_runningMs;
+    if (m_runClock.isValid())
+	ms += m_runClock.elapsed();
+    return ms;
+}
+
+qint64 KDebugger::stoppedTime() const
+{
+    if (!m_sessionClock.isValid())
+	return 0;
+    return m_sessionClock.elapsed() - runningTime();
 }
 
 void KDebugger::updateAllExprs()
@@ -1259,11 +1501,15 @@ void KDebugger::updateAllExprs()
     if (!m_programActive)
 	return;
 
-    // retrieve local variables
-    m_d->queueCmd(DCinfolocals, DebuggerDriver::QMoverride);
+    // retrieve local variables unless we have them already
+    if (!restoreLocals())
+	m_d->queueCmd(DCinfolocals, DebuggerDriver::QMoverride);
 
-    // retrieve registers
-    m_d->queueCmd(DCinforegisters, DebuggerDriver::QMoverride);
+    /*
+     * Registers and memory come after the variables and their members,
+     * which are usually what the user looks at first.
+     */
+    queueRegisters();
 
     // get new memory dump
     if (!m_memoryExpression.isEmpty()) {
@@ -1331,14 +1577,31 @@ void KDebugger::updateProgEnvironment(const QString& args, const QString& wd,
 
 void KDebugger::handleLocals(const char* output)
 {
-    // retrieve old list of local variables
-    QStringList oldVars = m_localVariables.exprList();
-
     /*
      *  Get local variables.
      */
     std::list<ExprValue*> newVars;
     parseLocals(output, newVars);
+    updateLocals(newVars);
+}
+
+/*
+ * Shows the local variables of the current frame. The values are consumed.
+ */
+void KDebugger::updateLocals(std::list<ExprValue*>& newVars)
+{
+    m_localsFrame = m_curFrame;
+    m_localsGeneration = m_d->stopGeneration();
+
+    if (m_localsModel != 0) {
+	m_localsModel->setValues(newVars);
+	return;
+    }
+
+    // retrieve old list of local variables
+    std::list<VarTree*> oldVars;
+    for (int i = 0; i < m_localVariables.topLevelItemCount(); i++)
+	oldVars.push_back(m_localVariables.topLevelItem(i));
 
     /*
      * Clear any old VarTree item pointers, so that later we don't access
@@ -1347,38 +1610,48 @@ void KDebugger::handleLocals(const char* output)
     m_localVariables.clearPendingUpdates();
 
     /*
-     * Match old variables against new ones.
+     * Match old variables against new ones by name. parseLocals() has
+     * renamed hidden variables, so the names are unique.
      */
-    for (QStringList::ConstIterator n = oldVars.begin(); n != oldVars.end(); ++n) {
-	// lookup this variable in the list of new variables
-	std::list<ExprValue*>::iterator v = newVars.begin();
-	while (v != newVars.end() && (*v)->m_name != *n)
-	    ++v;
-	if (v == newVars.end()) {
+    QHash<QString,ExprValue*> byName;
+    for (std::list<ExprValue*>::iterator v = newVars.begin(); v != newVars.end(); ++v)
+	byName.insert((*v)->m_name, *v);
+
+    QStringList added, removed, changed;
+    for (std::list<VarTree*>::iterator o = oldVars.begin(); o != oldVars.end(); ++o) {
+	QString name = (*o)->getText();
+	QHash<QString,ExprValue*>::iterator v = byName.find(name);
+	if (v == byName.end()) {
 	    // old variable not in the new variables
-	    TRACE("old var deleted: " + *n);
-	    VarTree* v = m_localVariables.topLevelExprByName(*n);
-	    if (v != 0) {
-		m_localVariables.removeExpr(v);
-	    }
+	    TRACE("old var deleted: " + name);
+	    removed.append(name);
+	    m_localVariables.removeExpr(*o);
+	} else if ((*o)->isSameLeaf(*v)) {
+	    // nothing to update; localsChanged() resets its color
+	    byName.erase(v);
 	} else {
 	    // variable in both old and new lists: update
-	    TRACE("update var: " + *n);
-	    m_localVariables.updateExpr(*v, *m_typeTable);
-	    // remove the new variable from the list
-	    delete *v;
-	    newVars.erase(v);
+	    TRACE("update var: " + name);
+	    if (m_localVariables.updateExpr(*o, *v, *m_typeTable))
+		changed.append(name);
+	    // the new variable is not inserted below
+	    byName.erase(v);
 	}
     }
-    // insert all remaining new variables
+    // insert all remaining new variables in the order that gdb reported
     while (!newVars.empty())
     {
 	ExprValue* v = newVars.front();
-	TRACE("new var: " + v->m_name);
-	m_localVariables.insertExpr(v, *m_typeTable);
+	if (byName.contains(v->m_name)) {
+	    TRACE("new var: " + v->m_name);
+	    added.append(v->m_name);
+	    m_localVariables.insertExpr(v, *m_typeTable);
+	}
 	delete v;
 	newVars.pop_front();
     }
+
+    emit localsChanged(added, removed, changed);
 }
 
 void KDebugger::parseLocals(const char* output, std::list<ExprValue*>& newVars)
@@ -1386,30 +1659,25 @@ void KDebugger::parseLocals(const char* output, std::list<ExprValue*>& newVars)
     std::list<ExprValue*> vars;
     m_d->parseLocals(output, vars);
 
-    QString origName;			/* used in renaming variables */
+    QHash<QString,int> seen;		/* how often each name occurred */
     while (!vars.empty())
     {
 	ExprValue* variable = vars.front();
 	vars.pop_front();
 	/*
 	 * When gdb prints local variables, those from the innermost block
-	 * come first. We run through the list of already parsed variables
-	 * to find duplicates (ie. variables that hide local variables from
-	 * a surrounding block). We keep the name of the inner variable, but
-	 * rename those from the outer block so that, when the value is
-	 * updated in the window, the value of the variable that is
-	 * _visible_ changes the color!
+	 * come first. A name that was seen before belongs to a variable
+	 * that is hidden by one of an inner block. We keep the name of the
+	 * inner variable, but rename those from the outer block so that,
+	 * when the value is updated in the window, the value of the
+	 * variable that is _visible_ changes the color!
 	 */
-	int block = 0;
-	origName = variable->m_name;
-	for (std::list<ExprValue*>::iterator v = newVars.begin(); v != newVars.end(); ++v) {
-	    if (variable->m_name == (*v)->m_name) {
-		// we found a duplicate, change name
-		block++;
-		QString newName = origName + " (" + QString().setNum(block) + ")";
-		variable->m_name = newName;
-	    }
+	int& block = seen[variable->m_name];
+	if (block > 0) {
+	    // we found a duplicate, change name
+	    variable->m_name += " (" + QString().setNum(block) + ")";
 	}
+	block++;
 	newVars.push_back(variable);
     }
 }
@@ -1453,7 +1721,10 @@ bool KDebugger::handlePrintPopup(CmdQueueItem* cmd, const char* output)
 
 bool KDebugger::handlePrintDeref(CmdQueueItem* cmd, const char* output)
 {
-    ASSERT(cmd->m_expr != 0);
+    if (!cmd->m_modelExpr.isEmpty() && m_localsModel != 0)
+	m_localsModel->setDerefValue(cmd->m_modelExpr, m_d->parsePrintExpr(output, true));
+    if (cmd->m_expr == 0)
+	return false;			/* only the model wanted it */
 
     ExprValue* variable = m_d->parsePrintExpr(output, true);
     if (variable == 0)
@@ -1487,40 +1758,365 @@ bool KDebugger::handlePrintDeref(CmdQueueItem* cmd, const char* output)
     return true;
 }
 
-// parse the output of bt
-void KDebugger::handleBacktrace(const char* output)
+/*
+ * Strips the arguments and the source position from the text of a frame
+ * in the stack window, so that only the function name remains.
+ */
+static QString functionOfFrame(const QString& frame)
+{
+    static const char* const ends[] = { " (", " at ", " from " };
+    int len = frame.length();
+    for (unsigned i = 0; i < sizeof(ends)/sizeof(ends[0]); i++) {
+	int e = frame.indexOf(ends[i]);
+	if (e >= 0 && e < len)
+	    len = e;
+    }
+    return frame.left(len);
+}
+
+/*
+ * The function name alone is ambiguous: static functions in different
+ * files can have the same name. The base name of the file is used because
+ * the drivers report the file differently in backtraces and frame changes.
+ */
+static QString frameScope(const QString& frame, const QString& file)
+{
+    return functionOfFrame(frame) + '\n' + QFileInfo(file).fileName();
+}
+
+static QString frameText(const StackFrame& frm)
+{
+    if (frm.var != 0)
+	return frm.var->m_name;
+    else
+	return frm.fileName + ":" + QString().setNum(frm.lineNo+1);
+}
+
+/*
+ * Requests the innermost window of the backtrace after the program
+ * stopped.
+ */
+void KDebugger::queueBacktrace()
+{
+    m_btFrames = btWindowSize;
+    CmdQueueItem* cmd = m_d->queueCmd(DCbt, m_btFrames, DebuggerDriver::QMoverride);
+    cmd->m_frameNo = 0;
+}
+
+int KDebugger::btFrameCount() const
+{
+    return m_btWindow.count() - (m_btMore ? 1 : 0);
+}
+
+/*
+ * Parses the output of bt. Returns true if this is the stack of a new
+ * stop; false if more frames of the stack that is shown were listed.
+ */
+bool KDebugger::handleBacktrace(CmdQueueItem* cmd, const char* output)
 {
-    m_btWindow.clear();
+    bool newStack = cmd->m_frameNo == 0;
+    if (!newStack && cmd->m_generation != m_btGeneration)
+	return false;			/* more frames of an old stack */
 
     std::list<StackFrame> stack;
-    m_d->parseBackTrace(output, stack);
+    bool more = m_d->parseBackTrace(output, stack);
+
+    if (!newStack && cmd->m_frameNo == m_btCheckLevel) {
+	reuseOuterFrames(stack);
+	return false;
+    }
+
+    // one frame more than is shown is requested to see whether there are more
+    while (!stack.empty() && stack.back().frameNo >= m_btFrames) {
+	stack.pop_back();
+	more = true;
+    }
+
+    // changing the rows must not select a frame
+    m_btWindow.blockSignals(true);
+
+    if (newStack) {
+	discardOldFrames();
+	if (!m_btMore && m_d->canListFrameRange()) {
+	    // keep the rows of the complete stack for checkOuterFrames()
+	    while (m_btWindow.count() > 0)
+		m_btOldFrames.prepend(m_btWindow.takeItem(m_btWindow.count()-1));
+	} else {
+	    m_btWindow.clear();
+	}
+	m_curScope = QString();
+	m_btGeneration = cmd->m_generation;
+    } else if (m_btMore) {
+	delete m_btWindow.takeItem(m_btWindow.count()-1);
+    }
+    m_btMore = false;
 
-    if (!stack.empty()) {
-	std::list<StackFrame>::iterator frm = stack.begin();
+    if (newStack && !stack.empty()) {
+	StackFrame& frm = stack.front();
 	// first frame must set PC
-	// note: frm->lineNo is zero-based
-	emit updatePC(frm->fileName, frm->lineNo, frm->address, frm->frameNo);
+	// note: frm.lineNo is zero-based
+	emit updatePC(frm.fileName, frm.lineNo, frm.address, frm.frameNo);
+	m_curScope = frameScope(frameText(frm), frm.fileName);
+	m_curFrame = 0;
+    }
 
-	for (; frm != stack.end(); ++frm) {
-	    QString func;
-	    if (frm->var != 0)
-		func = frm->var->m_name;
-	    else
-		func = frm->fileName + ":" + QString().setNum(frm->lineNo+1);
-        
- 	    m_btWindow.addItem(func);
-	    TRACE("frame " + func + " (" + frm->fileName + ":" +
-		  QString().setNum(frm->lineNo+1) + ")");
+    for (std::list<StackFrame>::iterator frm = stack.begin(); frm != stack.end(); ++frm) {
+	// frames that are shown already are not added again
+	if (frm->frameNo < m_btWindow.count())
+	    continue;
+	QString func = frameText(*frm);
+	QListWidgetItem* item = new QListWidgetItem(func, &m_btWindow);
+	item->setData(Qt::UserRole, frm->address.asString());
+	TRACE("frame " + func + " (" + frm->fileName + ":" +
+	      QString().setNum(frm->lineNo+1) + ")");
+    }
+
+    if (more) {
+	m_btWindow.addItem(i18n("(more frames)"));
+	m_btMore = true;
+    }
+    m_btWindow.blockSignals(false);
+
+    if (newStack) {
+	if (more)
+	    checkOuterFrames();
+	else
+	    discardOldFrames();
+    }
+    return newStack;
+}
+
+/*
+ * The outer frames of the previous stack are unchanged if the callers in
+ * the first window are at the same addresses and the stack has still the
+ * same outermost frame. The latter is requested from the driver; the
+ * frame beyond it must not exist.
+ */
+void KDebugger::checkOuterFrames()
+{
+    int count = btFrameCount();
+    if (m_btOldFrames.size() <= count) {
+	discardOldFrames();
+	return;
+    }
+    for (int i = 1; i < count; i++) {
+	if (m_btOldFrames[i]->data(Qt::UserRole) != m_btWindow.item(i)->data(Qt::UserRole)) {
+	    discardOldFrames();
+	    return;
 	}
     }
+    m_btCheckLevel = m_btOldFrames.size()-1;
+    CmdQueueItem* cmd = m_d->queueCmd(DCbtrange, m_btCheckLevel, m_btCheckLevel+1,
+				      DebuggerDriver::QMoverride);
+    cmd->m_frameNo = m_btCheckLevel;
+}
 
+void KDebugger::reuseOuterFrames(const std::list<StackFrame>& stack)
+{
+    QString addr = m_btOldFrames.last()->data(Qt::UserRole).toString();
+    bool same = stack.size() == 1 &&
+	stack.front().frameNo == m_btCheckLevel &&
+	!addr.isEmpty() && stack.front().address.asString() == addr;
+
+    if (same && m_btMore) {
+	TRACE("reusing frames from " + QString::number(btFrameCount()));
+	m_btWindow.blockSignals(true);
+	delete m_btWindow.takeItem(m_btWindow.count()-1);
+	for (int i = m_btWindow.count(); i < m_btOldFrames.size(); i++) {
+	    m_btWindow.addItem(m_btOldFrames[i]);
+	    m_btOldFrames[i] = 0;
+	}
+	m_btMore = false;
+	m_btFrames = m_btWindow.count();
+	m_btWindow.blockSignals(false);
+    }
+    discardOldFrames();
+
+    // the user may have scrolled to the placeholder in the meantime
+    slotBacktraceScrolled(m_btWindow.verticalScrollBar()->value());
+}
+
+void KDebugger::discardOldFrames()
+{
+    qDeleteAll(m_btOldFrames);
+    m_btOldFrames.clear();
+    m_btCheckLevel = -1;
+}
+
+/*
+ * Requests the next window of the backtrace when the user scrolled to the
+ * end of the list. Only the frames of the new window are listed if the
+ * driver can do so.
+ */
+void KDebugger::slotBacktraceScrolled(int value)
+{
+    if (!m_btMore || value < m_btWindow.verticalScrollBar()->maximum())
+	return;
+    // is the next window or a new stack requested already? are the outer
+    // frames of the previous stack being checked?
+    if (m_btFrames > btFrameCount() || m_btGeneration != m_d->stopGeneration() ||
+	m_btCheckLevel >= 0)
+	return;
+    int low = btFrameCount();
+    m_btFrames = low + btWindowSize;
+    CmdQueueItem* cmd;
+    if (m_d->canListFrameRange()) {
+	cmd = m_d->queueCmd(DCbtrange, low, m_btFrames, DebuggerDriver::QMoverride);
+    } else {
+	cmd = m_d->queueCmd(DCbt, m_btFrames, DebuggerDriver::QMoverride);
+    }
+    cmd->m_frameNo = low;
 }
 
 void KDebugger::gotoFrame(int frame)
 {
+    if (m_btMore && frame == btFrameCount()) {
+	// the placeholder was selected
+	slotBacktraceScrolled(m_btWindow.verticalScrollBar()->maximum());
+	return;
+    }
+    if (frame >= 0 && frame != m_localsFrame)
+	stashLocals();
     m_d->executeCmd(DCframe, frame);
 }
 
+void KDebugger::validateFrameLocals()
+{
+    int gen = m_d->stopGeneration();
+    if (gen != m_frameLocalsGeneration) {
+	clearFrameLocals();
+	m_frameLocalsGeneration = gen;
+    }
+}
+
+void KDebugger::clearFrameLocals()
+{
+    while (!m_frameLocals.empty())
+	dropFrameLocals(m_frameLocals.begin()->first);
+}
+
+/*
+ * Forgets the kept locals of one frame after its variables were changed
+ * behind the back of the cache.
+ */
+void KDebugger::dropFrameLocals(int frame)
+{
+    std::map<int,FrameLocals>::iterator f = m_frameLocals.find(frame);
+    if (f == m_frameLocals.end())
+	return;
+    qDeleteAll(f->second.items);
+    for (std::list<ExprValue*>::iterator v = f->second.values.begin();
+	 v != f->second.values.end(); ++v)
+    {
+	delete *v;
+    }
+    m_frameLocals.erase(f);
+}
+
+/*
+ * Moves the evaluated locals out of the window before another frame is
+ * shown. Incomplete values are not kept, because the commands that would
+ * complete them go away with the items.
+ */
+void KDebugger::stashLocals()
+{
+    if (m_localsGeneration != m_d->stopGeneration() ||
+	m_localVariables.topLevelItemCount() == 0 ||
+	m_localVariables.hasPendingUpdates())
+    {
+	return;
+    }
+    for (int i = 0; i < m_localVariables.topLevelItemCount(); i++) {
+	if (m_d->hasCmdsForVar(m_localVariables.topLevelItem(i)))
+	    return;
+    }
+
+    validateFrameLocals();
+    TRACE(QString().sprintf("keeping locals of frame %d", m_localsFrame));
+    FrameLocals& f = m_frameLocals[m_localsFrame];
+    qDeleteAll(f.items);
+    f.expanded.clear();
+    f.items = m_localVariables.takeExprs(f.expanded);
+    m_localsFrame = -1;
+}
+
+/*
+ * Shows the locals of the current frame if they are in the cache.
+ */
+bool KDebugger::restoreLocals()
+{
+    validateFrameLocals();
+    std::map<int,FrameLocals>::iterator f = m_frameLocals.find(m_curFrame);
+    if (f == m_frameLocals.end())
+	return false;
+
+    bool found = true;
+    if (!f->second.items.isEmpty()) {
+	TRACE(QString().sprintf("restoring locals of frame %d", m_curFrame));
+	QList<VarTree*> expanded;
+	qDeleteAll(m_localVariables.takeExprs(expanded));
+	m_localVariables.restoreExprs(f->second.items, f->second.expanded);
+	m_localsFrame = m_curFrame;
+	m_localsGeneration = m_d->stopGeneration();
+	// the struct values of the items are complete
+	for (std::list<ExprValue*>::iterator v = f->second.values.begin();
+	     v != f->second.values.end(); ++v)
+	{
+	    delete *v;
+	}
+    } else if (!f->second.values.empty()) {
+	TRACE(QString().sprintf("using prefetched locals of frame %d", m_curFrame));
+	updateLocals(f->second.values);
+    } else {
+	// the prefetch did not produce anything useful
+	found = false;
+    }
+    m_frameLocals.erase(f);
+    return found;
+}
+
+/*
+ * Obtains the locals of the callers of the current frame while the
+ * debugger is idle.
+ */
+void KDebugger::prefetchLocals()
+{
+    const int prefetchFrames = 3;
+
+    if (!m_d->canListFrameLocals())
+	return;
+
+    validateFrameLocals();
+    for (int frame = m_curFrame+1;
+	 frame <= m_curFrame+prefetchFrames && frame < btFrameCount();
+	 frame++)
+    {
+	if (frame == m_localsFrame || m_frameLocals.find(frame) != m_frameLocals.end())
+	    continue;
+	CmdQueueItem* cmd = m_d->queueCmd(DCframelocals, frame, DebuggerDriver::QMoverride);
+	cmd->m_frameNo = frame;
+	m_d->setCmdPriority(cmd, CPprefetch);
+	// one at a time; the next one is queued when the debugger is idle again
+	return;
+    }
+}
+
+void KDebugger::handleFrameLocals(CmdQueueItem* cmd, const char* output)
+{
+    // the program may have moved on in the meantime
+    validateFrameLocals();
+    if (cmd->m_generation != m_frameLocalsGeneration)
+	return;
+
+    /*
+     * An entry is made even if gdb reports an error, so that the frame
+     * is not tried again.
+     */
+    FrameLocals& f = m_frameLocals[cmd->m_frameNo];
+    if (f.items.isEmpty() && f.values.empty())
+	parseLocals(output, f.values);
+}
+
 void KDebugger::handleFrameChange(const char* output)
 {
     QString fileName;
@@ -1528,6 +2124,19 @@ void KDebugger::handleFrameChange(const char* output)
     int lineNo;
     DbgAddr address;
     if (m_d->parseFrameChange(output, frameNo, fileName, lineNo, address)) {
+	m_curFrame = frameNo;
+	if (frameNo >= 0 && frameNo < btFrameCount()) {
+	    /*
+	     * The backtrace may omit the arguments of the frames. The
+	     * output of DCframe shows them, if the driver lists the frame
+	     * like in a backtrace.
+	     */
+	    std::list<StackFrame> frm;
+	    m_d->parseBackTrace(output, frm);
+	    if (!frm.empty() && frm.front().frameNo == frameNo)
+		m_btWindow.item(frameNo)->setText(frameText(frm.front()));
+	    m_curScope = frameScope(m_btWindow.item(frameNo)->text(), fileName);
+	}
 	/* lineNo can be negative here if we can't find a file name */
 	emit updatePC(fileName, lineNo, address, frameNo);
     } else {
@@ -1545,6 +2154,7 @@ void KDebugger::evalExpressions()
     //   types in watch expressions
     //   struct members in local variables
     //   struct members in watch expressions
+    // Within each of these groups, the items in view come first.
     VarTree* exprItem = 0;
     if (!m_watchEvalExpr.empty())
     {
@@ -1555,8 +2165,7 @@ void KDebugger::evalExpressions()
     if (exprItem != 0) {
 	CmdQueueItem* cmd = m_d->queueCmd(DCprint, exprItem->getText(), DebuggerDriver::QMoverride);
 	// remember which expr this was
-	cmd->m_expr = exprItem;
-	cmd->m_exprWnd = &m_watchVariables;
+	m_d->setCmdExpr(cmd, exprItem, &m_watchVariables);
     } else {
 	ExprWnd* wnd;
 #define POINTER(widget) \
@@ -1592,7 +2201,7 @@ void KDebugger::evalExpressions()
 	// paranoia
 	if (exprItem->m_type == 0 || exprItem->m_type == TypeInfo::unknownType())
 	    goto repeat;
-	evalInitialStructExpression(exprItem, wnd, false);
+	evalInitialStructBatch(exprItem, wnd);
 	return;
 
 	type:
@@ -1603,7 +2212,8 @@ void KDebugger::evalExpressions()
 	 */
 	if (exprItem->m_type != 0)
 	    goto repeat;
-	determineType(wnd, exprItem);
+	if (!determineType(wnd, exprItem))
+	    goto repeat;
     }
 }
 
@@ -1621,22 +2231,89 @@ void KDebugger::dereferencePointer(ExprWnd* wnd, VarTree* exprItem,
 	cmd = m_d->queueCmd(DCprintDeref, expr, DebuggerDriver::QMoverride);
     }
     // remember which expr this was
-    cmd->m_expr = exprItem;
-    cmd->m_exprWnd = wnd;
+    m_d->setCmdExpr(cmd, exprItem, wnd);
+    if (!immediate)
+	prioritizeByView(cmd);
 }
 
-void KDebugger::determineType(ExprWnd* wnd, VarTree* exprItem)
+/*
+ * The lightweight Locals view wants the target of a pointer.
+ */
+void KDebugger::slotModelDeref(const QString& expr, bool immediate)
+{
+    if (m_d == 0 || !isProgramActive() || isProgramRunning())
+	return;
+    TRACE("dereferencing pointer: " + expr);
+    CmdQueueItem* cmd = m_d->queueCmd(DCprintDeref, expr,
+				      immediate ? DebuggerDriver::QMoverrideMoreEqual :
+						  DebuggerDriver::QMoverride);
+    cmd->m_modelExpr = expr;
+}
+
+/*
+ * Returns false if the type was known from an earlier DCfindType and no
+ * command had to be queued to evaluate the expression.
+ */
+bool KDebugger::determineType(ExprWnd* wnd, VarTree* exprItem)
 {
     ASSERT(exprItem->m_varKind == VarTree::VKstruct);
 
     QString expr = exprItem->computeExpr();
+    std::map<QString,QString>::iterator c = m_typeCache.find(typeCacheKey(expr));
+    if (c != m_typeCache.end()) {
+	TRACE("cached type of: " + expr);
+	return applyType(wnd, exprItem, c->second);
+    }
+
     TRACE("get type of: " + expr);
     CmdQueueItem* cmd;
     cmd = m_d->queueCmd(DCfindType, expr, DebuggerDriver::QMoverride);
+    // the frame may have changed by the time the response arrives
+    cmd->m_typeKey = typeCacheKey(expr);
 
     // remember which expr this was
-    cmd->m_expr = exprItem;
-    cmd->m_exprWnd = wnd;
+    m_d->setCmdExpr(cmd, exprItem, wnd);
+    prioritizeByView(cmd);
+    return true;
+}
+
+/*
+ * Commands for expressions that are scrolled out of view or hidden in
+ * collapsed items yield to those that update the visible rows.
+ */
+void KDebugger::prioritizeByView(CmdQueueItem* cmd)
+{
+    bool visible = cmd->m_expr != 0 && cmd->m_exprWnd->isItemVisible(cmd->m_expr);
+    std::list<ExprBatchItem>::const_iterator i;
+    for (i = cmd->m_batch.begin(); !visible && i != cmd->m_batch.end(); ++i)
+	visible = i->m_exprWnd->isItemVisible(i->m_expr);
+    m_d->setCmdPriority(cmd, visible ? CPvisible : CPoffscreen);
+}
+
+void KDebugger::slotViewportChanged()
+{
+    ExprWnd* wnd = qobject_cast<ExprWnd*>(sender());
+    if (wnd == 0 || m_d == 0)
+	return;
+
+    for (int i = 0; i < wnd->topLevelItemCount(); i++)
+    {
+	QList<CmdQueueItem*> cmds = m_d->queuedCmdsByVar(wnd->topLevelItem(i));
+	for (QList<CmdQueueItem*>::iterator c = cmds.begin(); c != cmds.end(); ++c)
+	{
+	    if ((*c)->m_priority == CPvisible || (*c)->m_priority == CPoffscreen)
+		prioritizeByView(*c);
+	}
+    }
+}
+
+/*
+ * The same expression can have different types in different functions,
+ * but not within the same function of the same executable.
+ */
+QString KDebugger::typeCacheKey(const QString& expr) const
+{
+    return m_curScope + '\n' + expr;
 }
 
 void KDebugger::handleFindType(CmdQueueItem* cmd, const char* output)
@@ -1646,38 +2323,49 @@ void KDebugger::handleFindType(CmdQueueItem* cmd, const char* output)
     {
 	ASSERT(cmd != 0 && cmd->m_expr != 0);
 
-	const TypeInfo* info = m_typeTable->lookup(type);
+	m_typeCache[cmd->m_typeKey] = type;
 
-	if (info == 0) {
-	    /*
-	     * We've asked gdb for the type of the expression in
-	     * cmd->m_expr, but it returned a name we don't know. The base
-	     * class (and member) types have been checked already (at the
-	     * time when we parsed that particular expression). Now it's
-	     * time to derive the type from the base classes as a last
-	     * resort.
-	     */
-	    info = cmd->m_expr->inferTypeFromBaseClass();
-	    // if we found a type through this method, register an alias
-	    if (info != 0) {
-		TRACE("infered alias: " + type);
-		m_typeTable->registerAlias(type, info);
-	    }
-	}
-	if (info == 0) {
-            TRACE("unknown type "+type);
-	    cmd->m_expr->m_type = TypeInfo::unknownType();
-	} else {
-	    cmd->m_expr->m_type = info;
-	    /* since this node has a new type, we get its value immediately */
-	    evalInitialStructExpression(cmd->m_expr, cmd->m_exprWnd, false);
+	if (applyType(cmd->m_exprWnd, cmd->m_expr, type))
 	    return;
-	}
     }
 
     evalExpressions();			/* queue more of them */
 }
 
+/*
+ * Assigns the type by the name that DCfindType reported. Returns true if
+ * the value of the expression is evaluated next.
+ */
+bool KDebugger::applyType(ExprWnd* wnd, VarTree* var, const QString& type)
+{
+    const TypeInfo* info = m_typeTable->lookup(type);
+
+    if (info == 0) {
+	/*
+	 * We've asked gdb for the type of the expression in var, but it
+	 * returned a name we don't know. The base class (and member) types
+	 * have been checked already (at the time when we parsed that
+	 * particular expression). Now it's time to derive the type from
+	 * the base classes as a last resort.
+	 */
+	info = var->inferTypeFromBaseClass();
+	// if we found a type through this method, register an alias
+	if (info != 0) {
+	    TRACE("infered alias: " + type);
+	    m_typeTable->registerAlias(type, info);
+	}
+    }
+    if (info == 0) {
+	TRACE("unknown type "+type);
+	var->m_type = TypeInfo::unknownType();
+	return false;
+    }
+    var->m_type = info;
+    /* since this node has a new type, we get its value immediately */
+    evalInitialStructExpression(var, wnd, false);
+    return true;
+}
+
 void KDebugger::handlePrintStruct(CmdQueueItem* cmd, const char* output)
 {
     VarTree* var = cmd->m_expr;
@@ -1692,6 +2380,77 @@ void KDebugger::handlePrintStruct(CmdQueueItem* cmd, const char* output)
     } else {
 	partExpr = m_d->parsePrintExpr(output, false);
     }
+
+    /* go for more sub-expressions if needed */
+    if (addStructPart(var, partExpr)) {
+	/* queue a new print command with quite high priority */
+	evalStructExpression(var, cmd->m_exprWnd, true);
+	return;
+    }
+
+    cmd->m_exprWnd->updateStructValue(var);
+
+    evalExpressions();			/* enqueue dereferenced pointers */
+}
+
+void KDebugger::handleBreakBatch(CmdQueueItem* cmd, const char* output)
+{
+    std::list<QByteArray> parts = m_d->parseBatchOutput(output);
+    std::list<QByteArray>::iterator p = parts.begin();
+
+    std::list<BrkptBatchItem>::iterator i;
+    for (i = cmd->m_brkptBatch.begin(); i != cmd->m_brkptBatch.end(); ++i)
+    {
+	// a missing part counts as failure; the breakpoint becomes orphaned
+	QByteArray part;
+	if (p != parts.end())
+	    part = *p++;
+	newBreakpoint(i->m_brkpt, i->m_existingBrkpt, part.constData());
+    }
+}
+
+void KDebugger::handlePrintStructBatch(CmdQueueItem* cmd, const char* output)
+{
+    std::list<QByteArray> parts = m_d->parseBatchOutput(output);
+    std::list<QByteArray>::iterator p = parts.begin();
+
+    std::list<ExprBatchItem> more;
+    std::list<ExprBatchItem>::iterator i;
+    for (i = cmd->m_batch.begin(); i != cmd->m_batch.end(); ++i)
+    {
+	ExprValue* partExpr = 0;
+	if (p != parts.end()) {
+	    partExpr = m_d->parsePrintExpr(p->constData(), false);
+	    ++p;
+	}
+	if (i->m_expr == 0) {
+	    // the variable has gone away meanwhile
+	    delete partExpr;
+	    continue;
+	}
+	if (addStructPart(i->m_expr, partExpr)) {
+	    more.push_back(*i);
+	} else {
+	    i->m_exprWnd->updateStructValue(i->m_expr);
+	}
+    }
+
+    /* go for the next sub-expressions of all structs at once */
+    if (!more.empty()) {
+	evalStructBatch(more);
+	return;
+    }
+
+    evalExpressions();			/* enqueue dereferenced pointers */
+}
+
+/*
+ * Adds the result of a sub-expression to the value of the struct. Takes
+ * ownership of partExpr. Returns true if there are more sub-expressions
+ * to evaluate.
+ */
+bool KDebugger::addStructPart(VarTree* var, ExprValue* partExpr)
+{
     bool errorValue =
 	partExpr == 0 ||
 	/* we only allow simple values at the moment */
@@ -1739,16 +2498,7 @@ void KDebugger::handlePrintStruct(CmdQueueItem* cmd, const char* output)
 	var->m_exprIndexUseGuard = false;
     }
 
-    /* go for more sub-expressions if needed */
-    if (var->m_exprIndex < var->m_type->m_numExprs) {
-	/* queue a new print command with quite high priority */
-	evalStructExpression(var, cmd->m_exprWnd, true);
-	return;
-    }
-
-    cmd->m_exprWnd->updateStructValue(var);
-
-    evalExpressions();			/* enqueue dereferenced pointers */
+    return var->m_exprIndex < var->m_type->m_numExprs;
 }
 
 /* queues the first printStruct command for a struct */
@@ -1769,13 +2519,98 @@ void KDebugger::evalInitialStructExpression(VarTree* var, ExprWnd* wnd, bool imm
 				immediate  ?  DebuggerDriver::QMoverrideMoreEqual
 				: DebuggerDriver::QMoverride);
 	// remember which expression this was
-	cmd->m_expr = var;
-	cmd->m_exprWnd = wnd;
+	m_d->setCmdExpr(cmd, var, wnd);
     }
 }
 
+/*
+ * Evaluates all structs that wait for an update in both expression
+ * windows, beginning with var. Instead of one print command per struct
+ * and sub-expression, the current sub-expressions of all structs are
+ * printed by a single command.
+ */
+void KDebugger::evalInitialStructBatch(VarTree* var, ExprWnd* wnd)
+{
+    std::list<ExprBatchItem> batch;
+    bool queued = false;
+    while (var != 0)
+    {
+	// paranoia
+	if (var->m_type == 0 || var->m_type == TypeInfo::unknownType()) {
+	    // nothing to do
+	} else if (var->m_type == TypeInfo::wchartType()) {
+	    evalInitialStructExpression(var, wnd, false);
+	    queued = true;
+	} else {
+	    var->m_exprIndex = 0;
+	    var->m_exprIndexUseGuard = true;
+	    var->m_partialValue = var->m_type->m_displayString[0];
+	    batch.push_back(ExprBatchItem(var, wnd));
+	}
+
+	wnd = &m_localVariables;
+	var = wnd->nextUpdateStruct();
+	if (var == 0) {
+	    wnd = &m_watchVariables;
+	    var = wnd->nextUpdateStruct();
+	}
+    }
+    if (batch.empty() && !queued) {
+	// go on with the other kinds of expressions
+	evalExpressions();
+	return;
+    }
+    evalStructBatch(batch);
+}
+
+/** queues the current sub-expressions of the structs in one command */
+void KDebugger::evalStructBatch(const std::list<ExprBatchItem>& batch)
+{
+    QStringList exprs;
+    std::list<ExprBatchItem> items;
+    std::list<ExprBatchItem>::const_iterator i;
+    for (i = batch.begin(); i != batch.end(); ++i)
+    {
+	bool isQStringData;
+	QString expr = structExpression(i->m_expr, isQStringData);
+	if (isQStringData) {
+	    // needs a parser of its own
+	    CmdQueueItem* cmd = m_d->queueCmd(DCprintQStringStruct, expr, DebuggerDriver::QMnormal);
+	    m_d->setCmdExpr(cmd, i->m_expr, i->m_exprWnd);
+	    prioritizeByView(cmd);
+	} else {
+	    exprs.append(expr);
+	    items.push_back(*i);
+	}
+    }
+    if (items.empty())
+	return;
+
+    CmdQueueItem* cmd = m_d->queueCmd(DCprintStructBatch, exprs.join("\n"),
+				      DebuggerDriver::QMnormal);
+    // remember which expressions these were
+    m_d->setCmdBatch(cmd, items);
+    prioritizeByView(cmd);
+}
+
 /** queues a printStruct command; var must have been initialized correctly */
 void KDebugger::evalStructExpression(VarTree* var, ExprWnd* wnd, bool immediate)
+{
+    bool isQStringData;
+    QString expr = structExpression(var, isQStringData);
+    DbgCommand dbgCmd = isQStringData ? DCprintQStringStruct : DCprintStruct;
+    CmdQueueItem* cmd = m_d->queueCmd(dbgCmd, expr,
+				      immediate  ?  DebuggerDriver::QMoverrideMoreEqual
+				      : DebuggerDriver::QMnormal);
+
+    // remember which expression this was
+    m_d->setCmdExpr(cmd, var, wnd);
+    if (!immediate)
+	prioritizeByView(cmd);
+}
+
+/** the current sub-expression of a struct; it may be a QString::Data */
+QString KDebugger::structExpression(VarTree* var, bool& isQStringData)
 {
     QString base = var->computeExpr();
     QString expr;
@@ -1792,14 +2627,14 @@ void KDebugger::evalStructExpression(VarTree* var, ExprWnd* wnd, bool immediate)
 
     expr.replace("%s", base);
 
-    DbgCommand dbgCmd = DCprintStruct;
+    isQStringData = false;
     // check if this is a QString::Data
     if (expr.left(15) == "/QString::Data ")
     {
 	if (m_typeTable->parseQt2QStrings())
 	{
 	    expr = expr.mid(15, expr.length());	/* strip off /QString::Data */
-	    dbgCmd = DCprintQStringStruct;
+	    isQStringData = true;
 	} else {
 	    /*
 	     * This should not happen: the type libraries should be set up
@@ -1812,13 +2647,7 @@ void KDebugger::evalStructExpression(VarTree* var, ExprWnd* wnd, bool immediate)
 	}
     }
     TRACE("evalStruct: " + expr + (var->m_exprIndexUseGuard ? " // guard" : " // real"));
-    CmdQueueItem* cmd = m_d->queueCmd(dbgCmd, expr,
-				      immediate  ?  DebuggerDriver::QMoverrideMoreEqual
-				      : DebuggerDriver::QMnormal);
-
-    // remember which expression this was
-    cmd->m_expr = var;
-    cmd->m_exprWnd = wnd;
+    return expr;
 }
 
 void KDebugger::handleSharedLibs(const char* output)
@@ -1842,13 +2671,77 @@ CmdQueueItem* KDebugger::loadCoreFile()
 void KDebugger::slotExpanding(QTreeWidgetItem* item)
 {
     VarTree* exprItem = static_cast<VarTree*>(item);
+    ExprWnd* wnd = static_cast<ExprWnd*>(item->treeWidget());
+    if (exprItem->m_nameKind == VarTree::NKmore) {
+	fetchArrayPage(wnd, exprItem);
+	return;
+    }
     if (exprItem->m_varKind != VarTree::VKpointer) {
 	return;
     }
-    ExprWnd* wnd = static_cast<ExprWnd*>(item->treeWidget());
     dereferencePointer(wnd, exprItem, true);
 }
 
+/*
+ * The index that follows the array elements in front of the item that
+ * stands for the elements that were not printed.
+ */
+static int nextArrayIndex(VarTree* more)
+{
+    VarTree* array = static_cast<VarTree*>(more->parent());
+    int i = array->indexOfChild(more);
+    if (i <= 0)
+	return 0;
+    // the name is either [i] or [i .. j] for repeated values
+    QString name = array->child(i-1)->getText();
+    int end = name.length()-1;
+    int start = end;
+    while (start > 0 && name[start-1].isDigit())
+	start--;
+    return name.mid(start, end-start).toInt() + 1;
+}
+
+void KDebugger::fetchArrayPage(ExprWnd* wnd, VarTree* more)
+{
+    VarTree* array = static_cast<VarTree*>(more->parent());
+    ASSERT(array != 0 && array->m_varKind == VarTree::VKarray);
+
+    int pageSize = m_d->arrayPageSize();
+    if (pageSize <= 0)
+	pageSize = DebuggerDriver::defaultArrayPageSize;
+    /*
+     * Print the next page, but not beyond the end of the array:
+     * (a)[start]@(n-start < page ? n-start : page) with n being the
+     * number of elements of a. The driver creates NKmore items only for
+     * plain arrays, where sizeof gives the number of elements.
+     */
+    QString base = array->computeExpr();
+    QString n = QString("(sizeof(%1)/sizeof((%1)[0]))").arg(base);
+    QString expr = QString("(%1)[%2]@(%3-%2<%4?%3-%2:%4)")
+	.arg(base, QString::number(nextArrayIndex(more)), n, QString::number(pageSize));
+    TRACE("fetching array page: " + expr);
+    CmdQueueItem* cmd = m_d->queueCmd(DCprintPage, expr, DebuggerDriver::QMoverrideMoreEqual);
+    // remember which expr this was
+    m_d->setCmdExpr(cmd, more, wnd);
+}
+
+void KDebugger::handlePrintPage(CmdQueueItem* cmd, const char* output)
+{
+    ASSERT(cmd->m_expr != 0);
+
+    // an error means that there are no more elements
+    ExprValue* page = m_d->parsePrintExpr(output, false);
+    if (page != 0 && page->m_varKind != VarTree::VKarray) {
+	delete page;
+	page = 0;
+    }
+    cmd->m_exprWnd->insertArrayPage(cmd->m_expr, page, nextArrayIndex(cmd->m_expr),
+				    *m_typeTable);
+    delete page;
+
+    evalExpressions();			/* enqueue dereferenced pointers */
+}
+
 // add the expression in the edit field to the watch expressions
 void KDebugger::addWatch(const QString& t)
 {
@@ -1892,7 +2785,62 @@ void KDebugger::slotDeleteWatch()
 
 void KDebugger::handleRegisters(const char* output)
 {
-    emit registersChanged(m_d->parseRegisters(output));
+    std::list<RegisterInfo> regs = m_d->parseRegisters(output);
+    emit registersChanged(regs);
+    // from now on only the wanted registers are requested
+    if (!regs.empty())
+	m_registersListed = true;
+}
+
+/*
+ * The complete list of registers is requested only once. Thereafter only
+ * the values of the registers that the Registers window shows are
+ * requested, and none at all while the window is hidden.
+ */
+void KDebugger::queueRegisters()
+{
+    if (!m_registersShown) {
+	m_registersStale = true;
+	return;
+    }
+    m_registersStale = false;
+
+    CmdQueueItem* cmd;
+    if (!m_registersListed)
+	cmd = m_d->queueCmd(DCinforegisters, DebuggerDriver::QMoverride);
+    else if (!m_wantedRegisters.isEmpty())
+	cmd = m_d->queueCmd(DCregistervalues, m_wantedRegisters.join(" "),
+			    DebuggerDriver::QMoverride);
+    else
+	return;
+    m_d->setCmdPriority(cmd, CPoffscreen);
+}
+
+void KDebugger::setRegistersShown(bool shown)
+{
+    m_registersShown = shown;
+    if (shown && m_registersStale && m_d != 0 && m_programActive && !m_programRunning)
+	queueRegisters();
+}
+
+void KDebugger::setWantedRegisters(const QStringList& names)
+{
+    // the values of registers that were not wanted until now are stale
+    QStringList added;
+    foreach (QString name, names) {
+	if (!m_wantedRegisters.contains(name))
+	    added.append(name);
+    }
+    m_wantedRegisters = names;
+
+    if (added.isEmpty() || !m_registersListed || !m_registersShown ||
+	m_d == 0 || !m_programActive || m_programRunning)
+    {
+	return;
+    }
+    CmdQueueItem* cmd = m_d->queueCmd(DCregistervalues, added.join(" "),
+				      DebuggerDriver::QMoverride);
+    m_d->setCmdPriority(cmd, CPvisible);
 }
 
 /*
@@ -1904,20 +2852,21 @@ void KDebugger::handleRegisters(const char* output)
  * breakpoints") are assigned negative ids, and they are tried to set later
  * when the program stops again at a breakpoint.
  */
-void KDebugger::newBreakpoint(CmdQueueItem* cmd, const char* output)
+void KDebugger::newBreakpoint(Breakpoint* newBp, int existingId, const char* output)
 {
     BrkptIterator bp;
-    if (cmd->m_brkpt != 0) {
+    if (newBp != 0) {
 	// a new breakpoint, put it in the list
-	assert(cmd->m_brkpt->id == 0);
-	m_brkpts.push_back(*cmd->m_brkpt);
-	delete cmd->m_brkpt;
+	assert(newBp->id == 0);
+	m_brkpts.push_back(*newBp);
+	delete newBp;
 	bp = m_brkpts.end();
 	--bp;
+	indexBreakpoint(bp);
     } else {
 	// an existing breakpoint was retried
-	assert(cmd->m_existingBrkpt != 0);
-	bp = breakpointById(cmd->m_existingBrkpt);
+	assert(existingId != 0);
+	bp = breakpointById(existingId);
 	if (bp == m_brkpts.end())
 	    return;
     }
@@ -1931,18 +2880,14 @@ void KDebugger::newBreakpoint(CmdQueueItem* cmd, const char* output)
     {
 	/*
 	 * Failure, the breakpoint could not be set. If this is a new
-	 * breakpoint, assign it a negative id. We look for the minimal id
-	 * of all breakpoints (that are already in the list) to get the new
-	 * id.
+	 * breakpoint, assign it a negative id below all ids that were
+	 * handed out.
 	 */
 	if (bp->id == 0)
 	{
-	    int minId = 0;
-	    for (BrkptIterator i = m_brkpts.begin(); i != m_brkpts.end(); ++i) {
-		if (i->id < minId)
-		    minId = i->id;
-	    }
-	    bp->id = minId-1;
+	    bp->id = m_minOrphanId-1;
+	    indexBreakpoint(bp);
+	    emit breakpointUpdated(*bp);
 	}
 	return;
     }
@@ -1960,11 +2905,51 @@ void KDebugger::newBreakpoint(CmdQueueItem* cmd, const char* output)
 	}
     }
 
+    // the hit rate counts from now on
+    if (!m_brkptSince.contains(id))
+	m_brkptSince.insert(id, runningTime());
+
+    Breakpoint old = *bp;
+    unindexBreakpoint(bp);
     bp->id = id;
     bp->fileName = file;
     bp->lineNo = lineNo;
     if (!address.isEmpty())
 	bp->address = address;
+    indexBreakpoint(bp);
+
+    if (old.id != 0)
+	emit breakpointRemoved(old);	/* a retried orphan */
+    emit breakpointUpdated(*bp);
+}
+
+/*
+ * Tells whether the Breakpoints window and the source windows would show
+ * the two breakpoints differently. The hit rate is not compared: it
+ * changes with the running time and is reported by breakpointRatesChanged().
+ */
+static bool sameBreakpoint(const Breakpoint& a, const Breakpoint& b)
+{
+    return a.id == b.id &&
+	a.type == b.type &&
+	a.temporary == b.temporary &&
+	a.enabled == b.enabled &&
+	a.location == b.location &&
+	a.text == b.text &&
+	a.address == b.address &&
+	a.condition == b.condition &&
+	a.condTarget == b.condTarget &&
+	a.ignoreCount == b.ignoreCount &&
+	a.hitCount == b.hitCount &&
+	a.fileName == b.fileName &&
+	a.lineNo == b.lineNo;
+}
+
+static bool sameLocation(const Breakpoint& a, const Breakpoint& b)
+{
+    return a.fileName == b.fileName &&
+	a.lineNo == b.lineNo &&
+	a.address == b.address;
 }
 
 void KDebugger::updateBreakList(const char* output)
@@ -1975,12 +2960,21 @@ void KDebugger::updateBreakList(const char* output)
 
     // merge existing information into the new list
     // then swap the old and new lists
+    // only the breakpoints that differ are reported
 
+    std::list<Breakpoint> removed;
+    std::list<BrkptIterator> updated;
+    QSet<int> listed;
+    bool ratesChanged = false;
     for (BrkptIterator bp = brks.begin(); bp != brks.end(); ++bp)
     {
+	listed.insert(bp->id);
+	bp->hitRate = hitRate(*bp);
 	BrkptIterator i = breakpointById(bp->id);
 	if (i != m_brkpts.end())
 	{
+	    if (i->hitRate != bp->hitRate)
+		ratesChanged = true;
 	    // preserve accurate location information
 	    // note that xsldbg doesn't have a location in
 	    // the listed breakpoint if it has just been set
@@ -1990,6 +2984,12 @@ void KDebugger::updateBreakList(const char* output)
 		bp->fileName = i->fileName;
 		bp->lineNo = i->lineNo;
 	    }
+	    if (!sameLocation(*i, *bp))
+		removed.push_back(*i);
+	    if (!sameBreakpoint(*i, *bp))
+		updated.push_back(bp);
+	} else {
+	    updated.push_back(bp);
 	}
     }
 
@@ -1998,10 +2998,42 @@ void KDebugger::updateBreakList(const char* output)
     {
 	if (bp->isOrphaned())
 	    brks.push_back(*bp);
+	else if (!listed.contains(bp->id))
+	    removed.push_back(*bp);
     }
 
     m_brkpts.swap(brks);
+    m_brkptById.clear();
+    m_brkptByPos.clear();
+    for (BrkptIterator bp = m_brkpts.begin(); bp != m_brkpts.end(); ++bp)
+	indexBreakpoint(bp);
+
+    // the iterators in updated now point into m_brkpts
+    for (std::list<Breakpoint>::iterator bp = removed.begin(); bp != removed.end(); ++bp)
+	emit breakpointRemoved(*bp);
+    for (std::list<BrkptIterator>::iterator bp = updated.begin(); bp != updated.end(); ++bp)
+	emit breakpointUpdated(**bp);
     emit breakpointsChanged();
+    if (ratesChanged)
+	emit breakpointRatesChanged();
+}
+
+/*
+ * The hits per second of running time since the breakpoint was set. The
+ * time that the program sits at a breakpoint does not count.
+ */
+double KDebugger::hitRate(const Breakpoint& bp)
+{
+    if (bp.id <= 0)
+	return 0;
+    qint64 running = runningTime();
+    QHash<int,qint64>::iterator since = m_brkptSince.find(bp.id);
+    if (since == m_brkptSince.end()) {
+	// set from gdb's command line, perhaps
+	since = m_brkptSince.insert(bp.id, running);
+    }
+    qint64 ms = running - *since;
+    return ms > 0 ? bp.hitCount * 1000.0 / ms : 0;
 }
 
 // look if there is at least one temporary breakpoint
@@ -2016,49 +3048,89 @@ bool KDebugger::stopMayChangeBreakList() const
     return false;
 }
 
-KDebugger::BrkptIterator KDebugger::breakpointByFilePos(QString file, int lineNo,
-					   const DbgAddr& address)
+KDebugger::BrkptPos KDebugger::breakpointPos(const QString& file, int lineNo)
 {
-    // look for exact file name match
-    for (BrkptIterator bp = m_brkpts.begin(); bp != m_brkpts.end(); ++bp)
-    {
-	if (bp->lineNo == lineNo &&
-	    bp->fileName == file &&
-	    (address.isEmpty() || bp->address == address))
-	{
-	    return bp;
-	}
-    }
-    // not found, so try basename
-    file = QFileInfo(file).fileName();
+    return BrkptPos(QFileInfo(file).fileName(), lineNo);
+}
 
-    for (BrkptIterator bp = m_brkpts.begin(); bp != m_brkpts.end(); ++bp)
-    {
-	// get base name of breakpoint's file
-	QString basename = QFileInfo(bp->fileName).fileName();
+void KDebugger::indexBreakpoint(BrkptIterator bp)
+{
+    if (bp->id != 0)
+	m_brkptById.insert(bp->id, bp);
+    if (bp->id < m_minOrphanId)
+	m_minOrphanId = bp->id;
+    m_brkptByPos.insert(breakpointPos(bp->fileName, bp->lineNo), bp);
+}
 
-	if (bp->lineNo == lineNo &&
-	    basename == file &&
-	    (address.isEmpty() || bp->address == address))
-	{
-	    return bp;
+void KDebugger::unindexBreakpoint(BrkptIterator bp)
+{
+    QHash<int,BrkptIterator>::iterator i = m_brkptById.find(bp->id);
+    if (i != m_brkptById.end() && i.value() == bp)
+	m_brkptById.erase(i);
+    m_brkptByPos.remove(breakpointPos(bp->fileName, bp->lineNo), bp);
+}
+
+/*
+ * A breakpoint whose file name matches exactly is preferred over one
+ * whose file name matches only in the base name.
+ */
+bool KDebugger::findBreakpoint(const QString& file, int lineNo,
+			       const DbgAddr& address, BrkptIterator& found) const
+{
+    bool any = false;
+    BrkptPos pos = breakpointPos(file, lineNo);
+    QMultiHash<BrkptPos,BrkptIterator>::const_iterator i = m_brkptByPos.find(pos);
+    for (; i != m_brkptByPos.end() && i.key() == pos; ++i)
+    {
+	BrkptIterator bp = i.value();
+	if (!address.isEmpty() && !(bp->address == address))
+	    continue;
+	if (bp->fileName == file) {
+	    found = bp;
+	    return true;
+	}
+	if (!any) {
+	    found = bp;
+	    any = true;
 	}
     }
+    return any;
+}
 
+KDebugger::BrkptIterator KDebugger::breakpointByFilePos(QString file, int lineNo,
+					   const DbgAddr& address)
+{
+    BrkptIterator bp;
+    if (findBreakpoint(file, lineNo, address, bp))
+	return bp;
     // not found
     return m_brkpts.end();
 }
 
+const Breakpoint* KDebugger::breakpointAt(const QString& file, int lineNo,
+					  const DbgAddr& address) const
+{
+    BrkptIterator bp;
+    if (findBreakpoint(file, lineNo, address, bp))
+	return &*bp;
+    return 0;
+}
+
 KDebugger::BrkptIterator KDebugger::breakpointById(int id)
 {
-    for (BrkptIterator bp = m_brkpts.begin(); bp != m_brkpts.end(); ++bp)
-    {
-	if (bp->id == id) {
-	    return bp;
-	}
-    }
-    // not found
-    return m_brkpts.end();
+    return m_brkptById.value(id, m_brkpts.end());
+}
+
+void KDebugger::removeAllBreakpoints()
+{
+    std::list<Breakpoint> brks;
+    brks.swap(m_brkpts);
+    m_brkptById.clear();
+    m_brkptByPos.clear();
+    m_minOrphanId = 0;
+    for (BrkptIterator bp = brks.begin(); bp != brks.end(); ++bp)
+	emit breakpointRemoved(*bp);
+    emit breakpointsChanged();
 }
 
 void KDebugger::slotValuePopup(const QString& expr)
@@ -2134,9 +3206,30 @@ void KDebugger::handleThreadList(const char* output)
     emit threadsChanged(m_d->parseThreadList(output));
 }
 
+void KDebugger::handleThreadStacks(const char* output)
+{
+    emit threadStacksChanged(m_d->parseThreadStacks(output));
+}
+
+void KDebugger::collectThreadStacks()
+{
+    if (m_d == 0 || !m_programActive || m_programRunning)
+	return;
+    // one round trip per stop is sufficient
+    int gen = m_d->stopGeneration();
+    if (gen == m_threadStacksGeneration)
+	return;
+    m_threadStacksGeneration = gen;
+
+    CmdQueueItem* cmd = m_d->queueCmd(DCbtall, DebuggerDriver::QMoverride);
+    m_d->setCmdPriority(cmd, CPoffscreen);
+}
+
 void KDebugger::setThread(int id)
 {
-    m_d->queueCmd(DCthread, id, DebuggerDriver::QMoverrideMoreEqual);
+    CmdQueueItem* cmd = m_d->queueCmd(DCthread, id, DebuggerDriver::QMoverrideMoreEqual);
+    // the values of the previous thread are no longer of interest
+    cmd->m_newStop = true;
 }
 
 void KDebugger::setMemoryExpression(const QString& memexpr)
@@ -2152,11 +3245,36 @@ void KDebugger::setMemoryExpression(const QString& memexpr)
     }
 }
 
+void KDebugger::setLocalsModel(ExprModel* model)
+{
+    if (model == m_localsModel)
+	return;
+
+    // the locals are evaluated again for the new display
+    m_localVariables.clearPendingUpdates();
+    while (m_localVariables.topLevelItemCount() > 0)
+	m_localVariables.removeExpr(m_localVariables.topLevelItem(0));
+    if (m_localsModel != 0) {
+	m_localsModel->clear();
+	disconnect(m_localsModel, 0, this, 0);
+    }
+    clearFrameLocals();
+    m_localsFrame = -1;
+    m_localsModel = model;
+    if (model != 0)
+	connect(model, SIGNAL(derefRequested(const QString&, bool)),
+		SLOT(slotModelDeref(const QString&, bool)));
+
+    if (isProgramActive() && !isProgramRunning())
+	m_d->queueCmd(DCinfolocals, DebuggerDriver::QMoverride);
+}
+
 void KDebugger::queueMemoryDump(bool immediate)
 {
-    m_d->queueCmd(DCexamine, m_memoryExpression, m_memoryFormat,
+    CmdQueueItem* cmd = m_d->queueCmd(DCexamine, m_memoryExpression, m_memoryFormat,
 		  immediate ? DebuggerDriver::QMoverrideMoreEqual :
 			      DebuggerDriver::QMoverride);
+    m_d->setCmdPriority(cmd, immediate ? CPvisible : CPoffscreen);
 }
 
 void KDebugger::handleMemoryDump(const char* output)
@@ -2182,6 +3300,9 @@ void KDebugger::handleSetPC(const char* /*output*/)
 {
     // TODO: handle errors
 
+    // the innermost frame is somewhere else now; its locals are stale
+    dropFrameLocals(0);
+
     // now go to the top-most frame
     // this also modifies the program counter indicator in the UI
     gotoFrame(0);
@@ -2199,8 +3320,7 @@ void KDebugger::slotValueEdited(VarTree* expr, const QString& text)
     // determine the lvalue to edit
     QString lvalue = expr->computeExpr();
     CmdQueueItem* cmd = m_d->executeCmd(DCsetvariable, lvalue, text);
-    cmd->m_expr = expr;
-    cmd->m_exprWnd = wnd;
+    m_d->setCmdExpr(cmd, expr, wnd);
 }
 
 void KDebugger::handleSetVariable(CmdQueueItem* cmd, const char* output)
@@ -2214,12 +3334,18 @@ void KDebugger::handleSetVariable(CmdQueueItem* cmd, const char* output)
 	return;
     }
 
+    /*
+     * The kept locals of the current frame are stale. So may be those of
+     * the other frames, which can see the variable through pointers and
+     * references.
+     */
+    clearFrameLocals();
+
     // get the new value
     QString expr = cmd->m_expr->computeExpr();
     CmdQueueItem* printCmd =
 	m_d->queueCmd(DCprint, expr, DebuggerDriver::QMoverrideMoreEqual);
-    printCmd->m_expr = cmd->m_expr;
-    printCmd->m_exprWnd = cmd->m_exprWnd;
+    m_d->setCmdExpr(printCmd, cmd->m_expr, cmd->m_exprWnd);
 }
 
 
@@ -7,6 +7,9 @@
 #ifndef DEBUGGER_H
 #define DEBUGGER_H
 
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPair>
 #include <QSet>
 #include <QStringList>
 #include <list>
@@ -15,6 +18,7 @@
 #include "exprwnd.h"			/* some compilers require this */
 
 class ExprWnd;
+class ExprModel;
 class VarTree;
 struct ExprValue;
 class ProgramTypeTable;
@@ -23,10 +27,14 @@ class KConfig;
 class KConfigBase;
 class KConfigGroup;
 class QListWidget;
+class QListWidgetItem;
 class RegisterInfo;
 class ThreadInfo;
+struct ThreadStack;
 class DebuggerDriver;
 class CmdQueueItem;
+struct ExprBatchItem;
+struct BrkptBatchItem;
 class Breakpoint;
 struct DisassembledCode;
 struct MemoryDump;
@@ -162,6 +170,12 @@ public:
      */
     void setRemoteDevice(const QString& remoteDevice) { m_remoteDevice = remoteDevice; }
 
+    /**
+     * Run the program under a local gdbserver, which evaluates the
+     * breakpoint conditions. A remote device takes precedence.
+     */
+    void setRunGdbserver(bool run) { m_runGdbserver = run; }
+
     /**
      * Run the debuggee until the specified line in the specified file is
      * reached.
@@ -284,6 +298,13 @@ public:
      */
     bool isProgramRunning() { return m_haveExecutable && m_programRunning; }
 
+    /**
+     * How many milliseconds the program has been running and has been
+     * stopped, respectively, since it was first started in this session.
+     */
+    qint64 runningTime() const;
+    qint64 stoppedTime() const;
+
     /**
      * Do we have an executable set?
      */
@@ -304,6 +325,14 @@ public:
     BrkptROIterator breakpointsBegin() const { return m_brkpts.begin(); }
     BrkptROIterator breakpointsEnd() const { return m_brkpts.end(); }
 
+    /**
+     * Looks up the breakpoint at the specified position. If the address
+     * is empty, only the file name and line number must match.
+     * @return 0 if there is no breakpoint.
+     */
+    const Breakpoint* breakpointAt(const QString& file, int lineNo,
+				   const DbgAddr& address) const;
+
     const QString& executable() const { return m_executable; }
 
     /**
@@ -341,6 +370,12 @@ public:
      */
     void setMemoryFormat(unsigned format) { m_memoryFormat = format; }
 
+    /**
+     * Shows the local variables in \a model instead of the ExprWnd that
+     * was passed to the constructor. Pass 0 to go back to the ExprWnd.
+     */
+    void setLocalsModel(ExprModel* model);
+
     // settings
     void saveSettings(KConfig*);
     void restoreSettings(KConfig*);
@@ -368,36 +403,85 @@ protected:
 			       const QSet<QString>& newOptions);
     void parseLocals(const char* output, std::list<ExprValue*>& newVars);
     void handleLocals(const char* output);
+    void updateLocals(std::list<ExprValue*>& newVars);
+    void handleFrameLocals(CmdQueueItem* cmd, const char* output);
+    void stashLocals();
+    bool restoreLocals();
+    void prefetchLocals();
+    void validateFrameLocals();
+    void clearFrameLocals();
+    void dropFrameLocals(int frame);
     bool handlePrint(CmdQueueItem* cmd, const char* output);
     bool handlePrintPopup(CmdQueueItem* cmd, const char* output);
     bool handlePrintDeref(CmdQueueItem* cmd, const char* output);
-    void handleBacktrace(const char* output);
+    bool handleBacktrace(CmdQueueItem* cmd, const char* output);
+    void queueBacktrace();
+    int btFrameCount() const;
+    void checkOuterFrames();
+    void reuseOuterFrames(const std::list<StackFrame>& stack);
+    void discardOldFrames();
     void handleFrameChange(const char* output);
     void handleFindType(CmdQueueItem* cmd, const char* output);
     void handlePrintStruct(CmdQueueItem* cmd, const char* output);
+    void handlePrintStructBatch(CmdQueueItem* cmd, const char* output);
+    void handleBreakBatch(CmdQueueItem* cmd, const char* output);
+    void handlePrintPage(CmdQueueItem* cmd, const char* output);
+    bool addStructPart(VarTree* var, ExprValue* partExpr);
     void handleSharedLibs(const char* output);
     void handleRegisters(const char* output);
+    void queueRegisters();
     void handleMemoryDump(const char* output);
     void handleInfoLine(CmdQueueItem* cmd, const char* output);
     void handleDisassemble(CmdQueueItem* cmd, const char* output);
     void handleThreadList(const char* output);
+    void handleThreadStacks(const char* output);
     void handleSetPC(const char* output);
     void handleSetVariable(CmdQueueItem* cmd, const char* output);
     void evalExpressions();
     void evalInitialStructExpression(VarTree* var, ExprWnd* wnd, bool immediate);
     void evalStructExpression(VarTree* var, ExprWnd* wnd, bool immediate);
+    void evalInitialStructBatch(VarTree* var, ExprWnd* wnd);
+    void evalStructBatch(const std::list<ExprBatchItem>& batch);
+    QString structExpression(VarTree* var, bool& isQStringData);
     void dereferencePointer(ExprWnd* wnd, VarTree* var, bool immediate);
-    void determineType(ExprWnd* wnd, VarTree* var);
+    void fetchArrayPage(ExprWnd* wnd, VarTree* more);
+    bool determineType(ExprWnd* wnd, VarTree* var);
+    bool applyType(ExprWnd* wnd, VarTree* var, const QString& type);
+    void prioritizeByView(CmdQueueItem* cmd);
+    QString typeCacheKey(const QString& expr) const;
+    void saveTypeCache(KConfig* config);
+    void restoreTypeCache(KConfig* config);
     void queueMemoryDump(bool immediate);
     CmdQueueItem* loadCoreFile();
     void openProgramConfig(const QString& name);
 
     typedef std::list<Breakpoint>::iterator BrkptIterator;
+    /**
+     * The breakpoints in m_brkpts indexed by id and by position, where
+     * the position is the base name of the file and the line number.
+     * Breakpoints that do not have an id yet are not in m_brkptById.
+     */
+    typedef QPair<QString,int> BrkptPos;
+    QHash<int,BrkptIterator> m_brkptById;
+    QMultiHash<BrkptPos,BrkptIterator> m_brkptByPos;
+    int m_minOrphanId;			/* the lowest id of an orphan so far */
+    static BrkptPos breakpointPos(const QString& file, int lineNo);
+    void indexBreakpoint(BrkptIterator bp);
+    void unindexBreakpoint(BrkptIterator bp);
+    bool findBreakpoint(const QString& file, int lineNo,
+			const DbgAddr& address, BrkptIterator& found) const;
     BrkptIterator breakpointByFilePos(QString file, int lineNo,
 				    const DbgAddr& address);
     BrkptIterator breakpointById(int id);
+    void removeAllBreakpoints();
     CmdQueueItem* executeBreakpoint(const Breakpoint* bp, bool queueOnly);
-    void newBreakpoint(CmdQueueItem* cmd, const char* output);
+    /**
+     * Sets several breakpoints in one exchange with the debugger if the
+     * driver supports it. Each item is either a new breakpoint or the
+     * id of an orphaned breakpoint.
+     */
+    void setBreakpoints(const std::list<BrkptBatchItem>& items, bool queueOnly);
+    void newBreakpoint(Breakpoint* newBp, int existingId, const char* output);
     void updateBreakList(const char* output);
     bool stopMayChangeBreakList() const;
     void saveBreakpoints(KConfig* config);
@@ -417,11 +501,66 @@ protected:
     QString m_attachedPid;		/* user input of attaching to pid */
     QString m_programArgs;
     QString m_remoteDevice;
+    bool m_runGdbserver;		/* run the program under gdbserver */
+    void connectRemote(const QString& device);
+    void startGdbserver();
     QString m_programWD;		/* working directory of gdb */
     std::map<QString,QString> m_envVars;	/* environment variables set by user */
     QSet<QString> m_boolOptions;	/* boolean options */
     QStringList m_sharedLibs;		/* shared libraries used by program */
     ProgramTypeTable* m_typeTable;	/* known types used by the program */
+    /**
+     * The results of DCfindType, keyed by the function and source file of
+     * the current frame and the expression; see typeCacheKey().
+     */
+    std::map<QString,QString> m_typeCache;
+    QString m_curScope;			/* function and file of the current frame */
+    int m_curFrame;			/* the frame selected in gdb */
+    /**
+     * The backtrace is listed in windows of btWindowSize frames. If there
+     * are more frames than were listed, the last row of the Stack window
+     * is a placeholder; when the user scrolls to it, the next window is
+     * requested.
+     */
+    static const int btWindowSize = 100;
+    int m_btFrames;			/* number of frames requested */
+    bool m_btMore;			/* whether the placeholder is shown */
+    int m_btGeneration;			/* the stop generation of the list */
+    /**
+     * The rows of the previous stack, if it was listed completely. When
+     * the first window of the new stack lists the same callers and the
+     * outermost frame is at the same level and address as before, the
+     * outer rows are moved over instead of being listed again.
+     */
+    QList<QListWidgetItem*> m_btOldFrames;
+    int m_btCheckLevel;			/* the level that is checked, or -1 */
+    int m_localsFrame;			/* the frame shown in the Locals window */
+    int m_localsGeneration;		/* the stop generation of the shown locals */
+    /**
+     * The local variables of frames that are not shown, so that switching
+     * to them does not evaluate everything again. Either the evaluated
+     * items of a frame that was shown earlier or the values that
+     * prefetchLocals() obtained are kept. The cache is valid only in the
+     * stop generation m_frameLocalsGeneration; switching threads starts a
+     * new generation.
+     */
+    struct FrameLocals {
+	QList<VarTree*> items;		/* detached from the Locals window */
+	QList<VarTree*> expanded;	/* the expanded ones among items */
+	std::list<ExprValue*> values;	/* prefetched values */
+    };
+    std::map<int,FrameLocals> m_frameLocals;
+    int m_frameLocalsGeneration;
+    int m_threadStacksGeneration;	/* the stop generation of the stacks */
+    bool m_registersListed;		/* whether all registers are known */
+    bool m_registersShown;		/* whether the Registers window is visible */
+    bool m_registersStale;		/* whether a register update was skipped */
+    QStringList m_wantedRegisters;	/* the registers that are shown */
+    QElapsedTimer m_sessionClock;	/* since the program was first run */
+    QElapsedTimer m_runClock;		/* since the program was resumed */
+    qint64 m_runningMs;			/* running time until the last stop */
+    QHash<int,qint64> m_brkptSince;	/* running time when a brkpt was set */
+    double hitRate(const Breakpoint& bp);
     KConfig* m_programConfig;		/* program-specific settings (brkpts etc) */
     void saveProgramSettings();
     void restoreProgramSettings();
@@ -438,16 +577,43 @@ protected slots:
     void slotInferiorRunning();
     void backgroundUpdate();
     void gotoFrame(int);
+    void slotBacktraceScrolled(int);
     void slotExpanding(QTreeWidgetItem*);
     void slotDeleteWatch();
     void slotValuePopup(const QString&);
     void slotDisassemble(const QString&, int);
     void slotValueEdited(VarTree*, const QString&);
+    void slotViewportChanged();
+    void slotModelDeref(const QString& expr, bool immediate);
 public slots:
     void setThread(int);
+    /**
+     * Requests the backtraces of all threads unless they were already
+     * requested since the program stopped. The result is reported by
+     * threadStacksChanged().
+     */
+    void collectThreadStacks();
+    /**
+     * Tells which registers the Registers window shows. Values of
+     * registers that were not shown until now are requested.
+     */
+    void setWantedRegisters(const QStringList& names);
+    /**
+     * Tells whether the Registers window is visible. Registers are not
+     * requested while it is hidden.
+     */
+    void setRegistersShown(bool shown);
     void shutdown();
 
 signals:
+    /**
+     * This signal is emitted after the local variables were updated. It
+     * reports the names of the variables that came into scope, went out
+     * of scope, and whose values changed.
+     */
+    void localsChanged(const QStringList& added, const QStringList& removed,
+		       const QStringList& changed);
+
     /**
      * This signal is emitted before the debugger is started. The slot is
      * supposed to set up m_inferiorTerminal.
@@ -508,16 +674,51 @@ signals:
      */
     void breakpointsChanged();
 
+    /**
+     * Indicates that a breakpoint was added or that some of its
+     * properties have changed. It is emitted before breakpointsChanged().
+     */
+    void breakpointUpdated(const Breakpoint& bp);
+
+    /**
+     * Indicates that the hit rates of breakpoints have changed. The
+     * breakpoints are not reported by breakpointUpdated() for this alone;
+     * the new rates are found by iterating over the breakpoints.
+     */
+    void breakpointRatesChanged();
+
+    /**
+     * Indicates that a breakpoint was removed or that it was moved away
+     * from the location and id that bp reports; in the latter case,
+     * breakpointUpdated() follows.
+     */
+    void breakpointRemoved(const Breakpoint& bp);
+
     /**
      * Indicates that the register values have possibly changed.
      */
     void registersChanged(const std::list<RegisterInfo>&);
 
+    /**
+     * Provides new values of some of the registers.
+     */
+    void registerValuesChanged(const std::list<RegisterInfo>&);
+
     /**
      * Indicates that the list of threads has possibly changed.
      */
     void threadsChanged(const std::list<ThreadInfo>&);
 
+    /**
+     * Provides the backtraces of all threads.
+     */
+    void threadStacksChanged(const std::list<ThreadStack>&);
+
+    /**
+     * Provides the lines that logpoints printed while the program runs.
+     */
+    void logpointOutput(const QStringList& lines);
+
     /**
      * Indicates that the value for a value popup is ready.
      */
@@ -555,6 +756,7 @@ signals:
 
 protected:
     ExprWnd& m_localVariables;
+    ExprModel* m_localsModel;		/* if set, shows the locals instead */
     ExprWnd& m_watchVariables;
     QListWidget& m_btWindow;
 
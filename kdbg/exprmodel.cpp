@@ -0,0 +1,338 @@
+/*
+ * Copyright Johannes Sixt
+ * This file is licensed under the GNU General Public License Version 2.
+ * See the file COPYING in the toplevel directory of the source directory.
+ */
+
+#include "exprmodel.h"
+#include "exprmodel.moc"
+#include "exprwnd.h"			/* ExprValue */
+#include <QBrush>
+#include <QColor>
+#include <kiconloader.h>		/* icons */
+#include <klocale.h>			/* i18n */
+#include "mydebug.h"
+
+
+ExprModel::ExprModel(const QString& colHeader, QObject* parent) :
+	QAbstractItemModel(parent),
+	m_colHeader(colHeader)
+{
+    ExprValue* root = new ExprValue(QString(), VarTree::NKplain);
+    root->m_varKind = VarTree::VKdummy;
+    m_root = new Node(root, 0, 0);
+    m_root->fetched = true;
+
+    m_pixPointer = UserIcon("pointer.xpm");
+    if (m_pixPointer.isNull())
+	TRACE("Can't load pointer.xpm");
+}
+
+ExprModel::~ExprModel()
+{
+    delete m_root->value;
+    delete m_root;
+}
+
+void ExprModel::setValues(std::list<ExprValue*>& values)
+{
+    ExprValue* root = new ExprValue(QString(), VarTree::NKplain);
+    root->m_varKind = VarTree::VKdummy;
+    // link the siblings directly; appendChild() would walk the list
+    ExprValue** tail = &root->m_child;
+    for (std::list<ExprValue*>::iterator v = values.begin(); v != values.end(); ++v)
+    {
+	*tail = *v;
+	tail = &(*v)->m_next;
+    }
+    values.clear();
+
+    // the pointers that are still expanded are requested again below
+    m_derefs.clear();
+    ExprValue* old = m_root->value;
+    updateChildren(m_root, root, QModelIndex());
+    // the nodes refer only to the new values now
+    delete old;
+}
+
+void ExprModel::clear()
+{
+    std::list<ExprValue*> none;
+    setValues(none);
+}
+
+ExprModel::Node* ExprModel::nodeOf(const QModelIndex& index) const
+{
+    if (!index.isValid())
+	return m_root;
+    return static_cast<Node*>(index.internalPointer());
+}
+
+void ExprModel::makeRows(Node* node)
+{
+    int row = 0;
+    for (ExprValue* v = node->value->m_child; v != 0; v = v->m_next)
+	node->children.append(new Node(v, node, row++));
+    node->fetched = true;
+}
+
+bool ExprModel::sameShape(const Node* node, const ExprValue* newValue)
+{
+    const ExprValue* v = newValue->m_child;
+    for (int i = 0; i < node->children.size(); i++, v = v->m_next)
+    {
+	if (v == 0)
+	    return false;
+	const Node* c = node->children[i];
+	const ExprValue* o = c->value;
+	// the target of a pointer is not part of the new value
+	if (o->m_name != v->m_name ||
+	    o->m_varKind != v->m_varKind ||
+	    (!c->deref && (o->m_child == 0) != (v->m_child == 0)))
+	{
+	    return false;
+	}
+    }
+    return v == 0;
+}
+
+/*
+ * Moves the node over to the new value. Rows whose values differ or
+ * differed before are reported, so that the view repaints only those.
+ */
+void ExprModel::updateChildren(Node* node, ExprValue* newValue, const QModelIndex& index)
+{
+    if (node->deref) {
+	if (newValue->m_varKind == VarTree::VKpointer && newValue->m_child == 0) {
+	    // keep showing the old target until the new one arrives
+	    newValue->m_child = node->value->m_child;
+	    node->value->m_child = 0;
+	    node->value = newValue;
+	    requestDeref(node, index, false);
+	    return;
+	}
+	node->deref = false;
+    }
+
+    bool same = sameShape(node, newValue);
+    node->value = newValue;
+    if (!node->fetched)
+	return;
+
+    if (!same) {
+	// the children are not comparable; replace them
+	if (!node->children.isEmpty()) {
+	    beginRemoveRows(index, 0, node->children.size()-1);
+	    qDeleteAll(node->children);
+	    node->children.clear();
+	    endRemoveRows();
+	}
+	int count = newValue->childCount();
+	if (count > 0) {
+	    beginInsertRows(index, 0, count-1);
+	    makeRows(node);
+	    endInsertRows();
+	}
+	return;
+    }
+
+    ExprValue* v = newValue->m_child;
+    int first = -1;
+    for (int i = 0; i < node->children.size(); i++, v = v->m_next)
+    {
+	Node* c = node->children[i];
+	bool wasChanged = c->changed;
+	c->changed = c->value->m_value != v->m_value;
+	updateChildren(c, v, createIndex(i, 0, c));
+	if (c->changed || wasChanged) {
+	    if (first < 0)
+		first = i;
+	} else if (first >= 0) {
+	    emit dataChanged(createIndex(first, 0, node->children[first]),
+			     createIndex(i-1, 1, node->children[i-1]));
+	    first = -1;
+	}
+    }
+    if (first >= 0) {
+	int last = node->children.size()-1;
+	emit dataChanged(createIndex(first, 0, node->children[first]),
+			 createIndex(last, 1, node->children[last]));
+    }
+}
+
+/*
+ * Like VarTree::computeExpr().
+ */
+QString ExprModel::computeExpr(const Node* node) const
+{
+    const ExprValue* v = node->value;
+    if (node->parent == m_root)
+	return v->m_name;
+
+    const Node* par = node->parent;
+    QString parentExpr = computeExpr(par);
+
+    // skip the name of a base class or anonymous struct or union
+    if (v->m_nameKind == VarTree::NKtype || v->m_nameKind == VarTree::NKanonymous)
+	return parentExpr;
+    if (v->m_nameKind == VarTree::NKaddress)
+	return "*" + parentExpr;
+
+    switch (par->value->m_varKind) {
+    case VarTree::VKarray:
+	{
+	    // use the first index of a range of repeated values
+	    QString index = v->m_name;
+	    int i = 1;
+	    while (i < index.length() && index[i].isDigit())
+		i++;
+	    if (i < index.length() && index[i] != ']')
+		index.remove(i, index.length()-i-1);
+	    return "(" + parentExpr + ")" + index;
+	}
+    case VarTree::VKstruct:
+	return "(" + parentExpr + ")." + v->m_name;
+    default:
+	return parentExpr;
+    }
+}
+
+void ExprModel::requestDeref(Node* node, const QModelIndex& index, bool immediate)
+{
+    QString expr = computeExpr(node);
+    m_derefs.insert(expr, QPersistentModelIndex(index));
+    emit derefRequested(expr, immediate);
+}
+
+void ExprModel::setDerefValue(const QString& expr, ExprValue* value)
+{
+    QPersistentModelIndex index = m_derefs.take(expr);
+    if (value == 0 || !index.isValid()) {
+	delete value;
+	return;
+    }
+    Node* n = nodeOf(index);
+    if (!n->deref || n->value->m_varKind != VarTree::VKpointer) {
+	delete value;
+	return;
+    }
+    // the name of the target is the address of the pointer
+    value->m_name = "*" + n->value->m_value;
+    value->m_nameKind = VarTree::NKaddress;
+
+    if (n->children.isEmpty()) {
+	n->value->m_child = value;
+	beginInsertRows(index, 0, 0);
+	makeRows(n);
+	endInsertRows();
+	return;
+    }
+
+    // update the target in place
+    ExprValue* old = n->value->m_child;
+    n->value->m_child = value;
+    Node* c = n->children.first();
+    bool wasChanged = c->changed;
+    bool renamed = old->m_name != value->m_name;
+    c->changed = old->m_value != value->m_value;
+    QModelIndex ci = createIndex(0, 0, c);
+    updateChildren(c, value, ci);
+    if (c->changed || wasChanged || renamed)
+	emit dataChanged(ci, createIndex(0, 1, c));
+    delete old;
+}
+
+QModelIndex ExprModel::index(int row, int column, const QModelIndex& parent) const
+{
+    Node* p = nodeOf(parent);
+    if (row < 0 || row >= p->children.size() || column < 0 || column > 1)
+	return QModelIndex();
+    return createIndex(row, column, p->children[row]);
+}
+
+QModelIndex ExprModel::parent(const QModelIndex& index) const
+{
+    Node* p = nodeOf(index)->parent;
+    if (p == 0 || p == m_root)
+	return QModelIndex();
+    return createIndex(p->row, 0, p);
+}
+
+int ExprModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.column() > 0)
+	return 0;
+    return nodeOf(parent)->children.size();
+}
+
+int ExprModel::columnCount(const QModelIndex&) const
+{
+    return 2;
+}
+
+QVariant ExprModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid())
+	return QVariant();
+
+    const Node* n = nodeOf(index);
+    switch (role) {
+    case Qt::DisplayRole:
+	return index.column() == 0 ? n->value->m_name : n->value->m_value;
+    case Qt::ForegroundRole:
+	if (index.column() == 1 && n->changed)
+	    return QBrush(QColor(Qt::red));
+	break;
+    case Qt::DecorationRole:
+	if (index.column() == 0 && n->value->m_varKind == VarTree::VKpointer)
+	    return m_pixPointer;
+	break;
+    }
+    return QVariant();
+}
+
+QVariant ExprModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+	return QVariant();
+    return section == 0 ? m_colHeader : i18n("Value");
+}
+
+bool ExprModel::hasChildren(const QModelIndex& parent) const
+{
+    if (parent.column() > 0)
+	return false;
+    const Node* n = nodeOf(parent);
+    if (n->fetched)
+	return !n->children.isEmpty() || n->deref;
+    return n->value->m_child != 0 || n->value->m_varKind == VarTree::VKpointer;
+}
+
+bool ExprModel::canFetchMore(const QModelIndex& parent) const
+{
+    const Node* n = nodeOf(parent);
+    return !n->fetched &&
+	(n->value->m_child != 0 || n->value->m_varKind == VarTree::VKpointer);
+}
+
+void ExprModel::fetchMore(const QModelIndex& parent)
+{
+    Node* n = nodeOf(parent);
+    if (n->fetched)
+	return;
+    if (n->value->m_varKind == VarTree::VKpointer && n->value->m_child == 0) {
+	// the target is inserted by setDerefValue()
+	n->fetched = true;
+	n->deref = true;
+	requestDeref(n, parent, true);
+	return;
+    }
+    int count = n->value->childCount();
+    if (count == 0) {
+	n->fetched = true;
+	return;
+    }
+    beginInsertRows(parent, 0, count-1);
+    makeRows(n);
+    endInsertRows();
+}
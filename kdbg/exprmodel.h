@@ -0,0 +1,104 @@
+/*
+ * Copyright Johannes Sixt
+ * This file is licensed under the GNU General Public License Version 2.
+ * See the file COPYING in the toplevel directory of the source directory.
+ */
+
+#ifndef EXPRMODEL_H
+#define EXPRMODEL_H
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QList>
+#include <QPixmap>
+#include <list>
+
+struct ExprValue;
+
+/**
+ * A lightweight alternative to ExprWnd for large variable trees. The
+ * values are kept in the ExprValue tree that the driver produced; rows
+ * are created only for the children of expanded entries, and a view such
+ * as QTreeView asks only for the data of the rows that it shows. When
+ * new values arrive, the rows are kept and the changed values are
+ * reported with dataChanged().
+ *
+ * Expanding a pointer emits derefRequested(); the target is shown below
+ * the pointer when it arrives through setDerefValue(), and it is
+ * requested again whenever new values arrive. Otherwise the model is
+ * read-only: values cannot be edited, the members of structs are not
+ * summarized using the type tables, and the remaining elements of a long
+ * array are not fetched.
+ */
+class ExprModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    ExprModel(const QString& colHeader, QObject* parent);
+    ~ExprModel();
+
+    /**
+     * Replaces the top-level values. Entries that are in the old and the
+     * new values at the same position are updated in place. The values
+     * are consumed.
+     */
+    void setValues(std::list<ExprValue*>& values);
+    /** Removes all values. */
+    void clear();
+    /**
+     * Shows \a value as the target of the pointer \a expr that was
+     * requested with derefRequested(). The value is consumed.
+     */
+    void setDerefValue(const QString& expr, ExprValue* value);
+
+    virtual QModelIndex index(int row, int column,
+			      const QModelIndex& parent = QModelIndex()) const;
+    virtual QModelIndex parent(const QModelIndex& index) const;
+    virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+    virtual int columnCount(const QModelIndex& parent = QModelIndex()) const;
+    virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+    virtual QVariant headerData(int section, Qt::Orientation orientation,
+				int role = Qt::DisplayRole) const;
+    virtual bool hasChildren(const QModelIndex& parent = QModelIndex()) const;
+    virtual bool canFetchMore(const QModelIndex& parent) const;
+    virtual void fetchMore(const QModelIndex& parent);
+
+signals:
+    /**
+     * The target of the pointer \a expr is wanted; \a immediate is true
+     * if the user has just expanded the pointer.
+     */
+    void derefRequested(const QString& expr, bool immediate);
+
+protected:
+    struct Node
+    {
+	ExprValue* value;
+	Node* parent;
+	int row;
+	bool fetched;			//!< whether the rows of the children exist
+	bool changed;			//!< whether the last update changed the value
+	bool deref;			//!< the child is the target of the pointer
+	QList<Node*> children;
+	Node(ExprValue* v, Node* p, int r) :
+		value(v), parent(p), row(r), fetched(false), changed(false),
+		deref(false) { }
+	~Node() { qDeleteAll(children); }
+    };
+    Node* nodeOf(const QModelIndex& index) const;
+    /** creates the rows for the children of \a node */
+    void makeRows(Node* node);
+    /** whether the children of \a node can be updated in place */
+    static bool sameShape(const Node* node, const ExprValue* newValue);
+    void updateChildren(Node* node, ExprValue* newValue, const QModelIndex& index);
+    /** the expression that evaluates to the value of \a node */
+    QString computeExpr(const Node* node) const;
+    void requestDeref(Node* node, const QModelIndex& index, bool immediate);
+
+    Node* m_root;			/* its value holds the top-level values */
+    QString m_colHeader;
+    QPixmap m_pixPointer;
+    QHash<QString,QPersistentModelIndex> m_derefs;	/* pointers waiting for their target */
+};
+
+#endif // EXPRMODEL_H
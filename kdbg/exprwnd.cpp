@@ -31,7 +31,9 @@ VarTree::VarTree(VarTree* parent, ExprValue* v) :
 {
     setText(v->m_name);
     updateValueText();
-    if (v->m_child != 0 || m_varKind == VarTree::VKpointer)
+    // array elements that were not printed can be fetched by expanding
+    if (v->m_child != 0 || m_varKind == VarTree::VKpointer ||
+	m_nameKind == VarTree::NKmore)
 	setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
     else
 	setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicator);
@@ -116,6 +118,14 @@ bool VarTree::isToplevelExpr() const
     return parent() == 0;
 }
 
+VarTree* VarTree::topLevel()
+{
+    QTreeWidgetItem* t = this;
+    while (t->parent() != 0)
+	t = t->parent();
+    return static_cast<VarTree*>(t);
+}
+
 bool VarTree::isAncestorEq(const VarTree* child) const
 {
     const QTreeWidgetItem* c = child;
@@ -165,6 +175,22 @@ bool VarTree::updateStructValue(const QString& newValue)
     return m_structChanged || prevValueChanged;
 }
 
+void VarTree::clearChanged()
+{
+    if (m_baseChanged || m_structChanged) {
+	m_baseChanged = m_structChanged = false;
+	setForeground(1, treeWidget()->palette().text());
+    }
+}
+
+bool VarTree::isSameLeaf(const ExprValue* v) const
+{
+    return (m_varKind == VKsimple || m_varKind == VKpointer) &&
+	v->m_varKind == m_varKind &&
+	childCount() == 0 && v->m_child == 0 && !isExpanded() &&
+	v->m_value == m_baseValue;
+}
+
 void VarTree::updateValueText()
 {
     if (m_baseValue.isEmpty()) {
@@ -275,7 +301,60 @@ ExprValue::ExprValue(const QString& name, VarTree::NameKind aKind) :
 ExprValue::~ExprValue()
 {
     delete m_child;
-    delete m_next;
+    // arrays can be very long; don't recurse along the siblings
+    while (m_next != 0) {
+	ExprValue* n = m_next;
+	m_next = n->m_next;
+	n->m_next = 0;
+	delete n;
+    }
+}
+
+/*
+ * Free ExprValues are kept in a list. The memory is allocated in blocks
+ * and is never given back to the heap; the pool only grows to the largest
+ * number of ExprValues that existed at the same time.
+ */
+union ExprValueSlot
+{
+    ExprValueSlot* m_next;
+    double m_align;
+    char m_storage[sizeof(ExprValue)];
+};
+
+static ExprValueSlot* freeExprValues = 0;
+static const int exprValueBlock = 512;
+static unsigned long exprValueAllocs = 0;
+
+void* ExprValue::operator new(size_t size)
+{
+    ASSERT(size == sizeof(ExprValue));
+    if (freeExprValues == 0) {
+	ExprValueSlot* block = static_cast<ExprValueSlot*>(
+		::operator new(exprValueBlock * sizeof(ExprValueSlot)));
+	for (int i = 0; i < exprValueBlock; i++) {
+	    block[i].m_next = freeExprValues;
+	    freeExprValues = &block[i];
+	}
+    }
+    ExprValueSlot* slot = freeExprValues;
+    freeExprValues = slot->m_next;
+    exprValueAllocs++;
+    return slot;
+}
+
+unsigned long ExprValue::allocations()
+{
+    return exprValueAllocs;
+}
+
+void ExprValue::operator delete(void* p)
+{
+    if (p == 0)
+	return;
+    ExprValueSlot* slot = static_cast<ExprValueSlot*>(p);
+    slot->m_next = freeExprValues;
+    freeExprValues = slot;
 }
 
 void ExprValue::appendChild(ExprValue* newChild)
@@ -323,6 +402,17 @@ ExprWnd::ExprWnd(QWidget* parent, const QString& colHeader) :
     m_pixPointer = UserIcon("pointer.xpm");
     if (m_pixPointer.isNull())
 	TRACE("Can't load pointer.xpm");
+
+    // scrolling emits many signals; report only where the user stopped
+    m_viewportTimer.setSingleShot(true);
+    m_viewportTimer.setInterval(100);
+    // the updates must be classified before viewportChanged() is handled
+    connect(&m_viewportTimer, SIGNAL(timeout()), SLOT(slotReclassifyUpdates()));
+    connect(&m_viewportTimer, SIGNAL(timeout()), SIGNAL(viewportChanged()));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)),
+	    &m_viewportTimer, SLOT(start()));
+    connect(this, SIGNAL(itemExpanded(QTreeWidgetItem*)),
+	    &m_viewportTimer, SLOT(start()));
 }
 
 ExprWnd::~ExprWnd()
@@ -343,6 +433,7 @@ VarTree* ExprWnd::insertExpr(ExprValue* expr, ProgramTypeTable& typeTable)
 {
     // append a new dummy expression
     VarTree* display = new VarTree(this, expr);
+    m_topLevelByName.insert(display->getText(), display);
 
     // replace it right away
     updateExpr(display, expr, typeTable);
@@ -352,14 +443,7 @@ VarTree* ExprWnd::insertExpr(ExprValue* expr, ProgramTypeTable& typeTable)
 void ExprWnd::updateExpr(ExprValue* expr, ProgramTypeTable& typeTable)
 {
     // search the root variable
-    VarTree* item = 0;
-    for (int i = 0; i < topLevelItemCount(); i++)
-    {
-	if (topLevelItem(i)->getText() == expr->m_name) {
-	    item = topLevelItem(i);
-	    break;
-	}
-    }
+    VarTree* item = topLevelExprByName(expr->m_name);
     if (item == 0) {
 	return;
     }
@@ -368,16 +452,17 @@ void ExprWnd::updateExpr(ExprValue* expr, ProgramTypeTable& typeTable)
     collectUnknownTypes(item);
 }
 
-void ExprWnd::updateExpr(VarTree* display, ExprValue* newValues, ProgramTypeTable& typeTable)
+bool ExprWnd::updateExpr(VarTree* display, ExprValue* newValues, ProgramTypeTable& typeTable)
 {
-    updateExprRec(display, newValues, typeTable);
+    bool changed = updateExprRec(display, newValues, typeTable);
     collectUnknownTypes(display);
+    return changed;
 }
 
 /*
  * returns true if there's a visible change
  */
-void ExprWnd::updateExprRec(VarTree* display, ExprValue* newValues, ProgramTypeTable& typeTable)
+bool ExprWnd::updateExprRec(VarTree* display, ExprValue* newValues, ProgramTypeTable& typeTable)
 {
     bool isExpanded = display->isExpanded();
 
@@ -391,7 +476,7 @@ void ExprWnd::updateExprRec(VarTree* display, ExprValue* newValues, ProgramTypeT
 	newValues->m_varKind == VarTree::VKdummy)
     {
 	replaceChildren(display, newValues);
-	return;
+	return true;
     }
 
     /*
@@ -435,11 +520,12 @@ void ExprWnd::updateExprRec(VarTree* display, ExprValue* newValues, ProgramTypeT
 	display->inferTypesOfChildren(typeTable);
 
 	// (note that the new value might not have a sub-tree at all)
-	return;
+	return true;
     }
 
     // display the new value
     updateSingleExpr(display, newValues);
+    bool changed = display->valueChanged();
 
     /*
      * If this is an expanded pointer, record it for being updated.
@@ -456,7 +542,7 @@ void ExprWnd::updateExprRec(VarTree* display, ExprValue* newValues, ProgramTypeT
 	 * can stop here.
 	 */
 	if (newValues->m_child == 0) {
-	    return;
+	    return changed;
 	}
     }
 
@@ -473,10 +559,12 @@ void ExprWnd::updateExprRec(VarTree* display, ExprValue* newValues, ProgramTypeT
 	    vDisplay->setText(vNew->m_name);
 	}
 	// recurse
-	updateExprRec(vDisplay, vNew, typeTable);
+	if (updateExprRec(vDisplay, vNew, typeTable))
+	    changed = true;
 
 	vNew = vNew->m_next;
     }
+    return changed;
 }
 
 void ExprWnd::updateSingleExpr(VarTree* display, ExprValue* newValue)
@@ -527,20 +615,94 @@ void ExprWnd::replaceChildren(VarTree* display, ExprValue* newValues)
 {
     ASSERT(display->childCount() == 0 || display->m_varKind != VarTree::VKsimple);
 
-    // delete all children of display
-    while (VarTree* c = display->child(0)) {
-	unhookSubtree(c);
-	delete c;
-    }
-    // insert copies of the newValues
-    for (ExprValue* v = newValues->m_child; v != 0; v = v->m_next)
+    /*
+     * Delete all children of display. They are taken out of the view in
+     * one go; removing them one by one would update the view each time.
+     * They are unhooked while they are still in the tree, so that their
+     * top-level expression can be found.
+     */
+    for (int i = 0; i < display->childCount(); i++)
+	unhookSubtree(display->child(i));
+    QList<QTreeWidgetItem*> oldItems = display->takeChildren();
+    for (int i = 0; i < oldItems.size(); i++)
+	delete oldItems[i];
+    // insert copies of the newValues; again, the view sees them only once
+    display->addChildren(makeItems(newValues));
+    if (display->treeWidget() != 0)
+	expandInitially(display, newValues);
+}
+
+/*
+ * Creates the items for the children of value. They are not part of a
+ * view yet, so that they can be inserted at once.
+ */
+QList<QTreeWidgetItem*> ExprWnd::makeItems(ExprValue* value)
+{
+    QList<QTreeWidgetItem*> items;
+    for (ExprValue* v = value->m_child; v != 0; v = v->m_next)
     {
-	VarTree* vNew = new VarTree(display, v);
+	VarTree* vNew = new VarTree(static_cast<VarTree*>(0), v);
 	// recurse
-	replaceChildren(vNew, v);
+	vNew->addChildren(makeItems(v));
+	items.append(vNew);
+    }
+    return items;
+}
+
+/*
+ * Items can be expanded only when they are in the view.
+ */
+void ExprWnd::expandInitially(VarTree* display, ExprValue* value)
+{
+    int i = 0;
+    for (ExprValue* v = value->m_child; v != 0; v = v->m_next, i++)
+    {
+	if (v->m_initiallyExpanded)
+	    display->child(i)->setExpanded(true);
+	if (v->m_child != 0)
+	    expandInitially(display->child(i), v);
     }
 }
 
+/*
+ * The elements of the page are numbered from 0; shift the index.
+ */
+static QString shiftIndex(const QString& name, int offset)
+{
+    if (!name.startsWith('[') || !name.endsWith(']'))
+	return name;
+    // the name is either [i] or [i .. j] for repeated values
+    QStringList idx = name.mid(1, name.length()-2).split(" .. ");
+    for (int i = 0; i < idx.size(); i++)
+	idx[i] = QString::number(idx[i].toInt() + offset);
+    return "[" + idx.join(" .. ") + "]";
+}
+
+void ExprWnd::insertArrayPage(VarTree* more, ExprValue* page, int start,
+			      ProgramTypeTable& typeTable)
+{
+    ASSERT(more->m_nameKind == VarTree::NKmore);
+    VarTree* array = static_cast<VarTree*>(more->parent());
+
+    // if there are no more elements, we are done with this array
+    if (page == 0 || page->m_child == 0) {
+	removeExpr(more);
+	return;
+    }
+
+    for (ExprValue* v = page->m_child; v != 0; v = v->m_next)
+	v->m_name = shiftIndex(v->m_name, start);
+    QList<QTreeWidgetItem*> items = makeItems(page);
+    for (int i = 0; i < items.size(); i++)
+	static_cast<VarTree*>(items[i])->inferTypesOfChildren(typeTable);
+
+    // the remaining elements follow the new ones
+    more->setExpanded(false);
+    array->insertChildren(array->indexOfChild(more), items);
+
+    collectUnknownTypes(static_cast<VarTree*>(items.first()));
+}
+
 void ExprWnd::collectUnknownTypes(VarTree* var)
 {
     QTreeWidgetItemIterator i(var);
@@ -587,12 +749,13 @@ QString ExprWnd::formatWCharPointer(QString value)
 
 VarTree* ExprWnd::topLevelExprByName(const QString& name) const
 {
-    for (int i = 0; i < topLevelItemCount(); i++)
-    {
-	if (topLevelItem(i)->getText() == name)
-	    return topLevelItem(i);
-    }
-    return 0;
+    /*
+     * Should the same name be present more than once, the item that was
+     * inserted first is the one that appears first in the list; values()
+     * returns the most recent insertion first.
+     */
+    QList<VarTree*> items = m_topLevelByName.values(name);
+    return items.isEmpty() ? 0 : items.last();
 }
 
 VarTree* ExprWnd::ptrMemberByName(VarTree* v, const QString& name)
@@ -634,9 +797,75 @@ void ExprWnd::removeExpr(VarTree* item)
 {
     unhookSubtree(item);
 
+    if (item->isToplevelExpr())
+	m_topLevelByName.remove(item->getText(), item);
     delete item;
 }
 
+static void collectExpanded(VarTree* item, QList<VarTree*>& expanded)
+{
+    if (!item->isExpanded())
+	return;
+    expanded.append(item);
+    for (int i = 0; i < item->childCount(); i++)
+	collectExpanded(item->child(i), expanded);
+}
+
+QList<VarTree*> ExprWnd::takeExprs(QList<VarTree*>& expanded)
+{
+    QList<VarTree*> items;
+    while (topLevelItemCount() > 0)
+    {
+	VarTree* item = topLevelItem(0);
+	// the expanded state is lost when the item leaves the tree
+	collectExpanded(item, expanded);
+	unhookSubtree(item);
+	items.append(static_cast<VarTree*>(takeTopLevelItem(0)));
+    }
+    m_topLevelByName.clear();
+    m_changedExprs.clear();
+    return items;
+}
+
+void ExprWnd::restoreExprs(const QList<VarTree*>& items, const QList<VarTree*>& expanded)
+{
+    for (QList<VarTree*>::const_iterator i = items.begin(); i != items.end(); ++i)
+    {
+	addTopLevelItem(*i);
+	m_topLevelByName.insert((*i)->getText(), *i);
+	if ((*i)->valueChanged())
+	    m_changedExprs.insert((*i)->getText());
+    }
+    // the values are complete; expanding must not dereference pointers again
+    blockSignals(true);
+    for (QList<VarTree*>::const_iterator i = expanded.begin(); i != expanded.end(); ++i)
+	(*i)->setExpanded(true);
+    blockSignals(false);
+}
+
+void ExprWnd::slotExprsChanged(const QStringList&, const QStringList& removed,
+			       const QStringList& changed)
+{
+    QSet<QString> now = changed.toSet();
+    m_changedExprs.subtract(now);
+    m_changedExprs.subtract(removed.toSet());
+    for (QSet<QString>::const_iterator i = m_changedExprs.begin(); i != m_changedExprs.end(); ++i)
+    {
+	VarTree* item = topLevelExprByName(*i);
+	if (item != 0)
+	    item->clearChanged();
+    }
+    m_changedExprs = now;
+}
+
+void ExprWnd::clear()
+{
+    clearPendingUpdates();
+    m_topLevelByName.clear();
+    m_changedExprs.clear();
+    QTreeWidget::clear();
+}
+
 void ExprWnd::unhookSubtree(VarTree* subTree)
 {
     // must remove any pointers scheduled for update from the list
@@ -646,6 +875,13 @@ void ExprWnd::unhookSubtree(VarTree* subTree)
     emit removingItem(subTree);
 }
 
+void ExprWnd::unhookSubtree(UpdateList& list, VarTree* subTree)
+{
+    unhookSubtree(list.visible, subTree);
+    unhookSubtree(list.offscreen, subTree);
+    unhookSubtree(list.unsorted, subTree);
+}
+
 void ExprWnd::unhookSubtree(std::list<VarTree*>& list, VarTree* subTree)
 {
     if (subTree == 0)
@@ -669,34 +905,78 @@ void ExprWnd::clearPendingUpdates()
     m_updateStruct.clear();
 }
 
-VarTree* ExprWnd::nextUpdatePtr()
+bool ExprWnd::hasPendingUpdates() const
 {
-    VarTree* ptr = 0;
-    if (!m_updatePtrs.empty()) {
-	ptr = m_updatePtrs.front();
-	m_updatePtrs.pop_front();
-    }
+    return !m_updatePtrs.empty() || !m_updateType.empty() || !m_updateStruct.empty();
+}
+
+/*
+ * Items that the user can see are updated first so that the values in
+ * the viewport appear quickly even if there are many variables.
+ */
+VarTree* ExprWnd::takeNextUpdate(UpdateList& list)
+{
+    classifyUpdates(list);
+
+    std::list<VarTree*>& from = !list.visible.empty() ? list.visible : list.offscreen;
+    if (from.empty())
+	return 0;
+    VarTree* ptr = from.front();
+    from.pop_front();
     return ptr;
 }
 
-VarTree* ExprWnd::nextUpdateType()
+/*
+ * Each item is examined once; its visibility is only checked again when
+ * the viewport changes.
+ */
+void ExprWnd::classifyUpdates(UpdateList& list) const
 {
-    VarTree* ptr = 0;
-    if (!m_updateType.empty()) {
-	ptr = m_updateType.front();
-	m_updateType.pop_front();
+    while (!list.unsorted.empty())
+    {
+	std::list<VarTree*>& to =
+	    isItemVisible(list.unsorted.front()) ? list.visible : list.offscreen;
+	to.splice(to.end(), list.unsorted, list.unsorted.begin());
     }
-    return ptr;
+}
+
+void ExprWnd::slotReclassifyUpdates()
+{
+    UpdateList* lists[] = { &m_updatePtrs, &m_updateType, &m_updateStruct };
+    for (size_t i = 0; i < sizeof(lists)/sizeof(lists[0]); i++)
+    {
+	UpdateList& l = *lists[i];
+	// keep the order in which the items were recorded within each part
+	l.unsorted.splice(l.unsorted.begin(), l.offscreen);
+	l.unsorted.splice(l.unsorted.begin(), l.visible);
+	classifyUpdates(l);
+    }
+}
+
+VarTree* ExprWnd::nextUpdatePtr()
+{
+    return takeNextUpdate(m_updatePtrs);
+}
+
+VarTree* ExprWnd::nextUpdateType()
+{
+    return takeNextUpdate(m_updateType);
 }
 
 VarTree* ExprWnd::nextUpdateStruct()
 {
-    VarTree* ptr = 0;
-    if (!m_updateStruct.empty()) {
-	ptr = m_updateStruct.front();
-	m_updateStruct.pop_front();
+    return takeNextUpdate(m_updateStruct);
+}
+
+bool ExprWnd::isItemVisible(VarTree* item) const
+{
+    if (!isVisible())
+	return false;
+    for (QTreeWidgetItem* p = item->parent(); p != 0; p = p->parent()) {
+	if (!p->isExpanded())
+	    return false;
     }
-    return ptr;
+    return visualItemRect(item).intersects(viewport()->rect());
 }
 
 
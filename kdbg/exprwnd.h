@@ -10,6 +10,9 @@
 #include <QTreeWidget>
 #include <QLineEdit>
 #include <QPixmap>
+#include <QTimer>
+#include <QMultiHash>
+#include <QSet>
 #include <list>
 
 class ProgramTypeTable;
@@ -28,7 +31,8 @@ public:
     VarKind m_varKind;
     enum NameKind { NKplain, NKstatic, NKtype,
 	NKanonymous,			//!< an anonymous struct or union
-	NKaddress			//!< a dereferenced pointer
+	NKaddress,			//!< a dereferenced pointer
+	NKmore				//!< array elements that were not printed
     };
     NameKind m_nameKind;
     const TypeInfo* m_type;			//!< the type of struct if it could be derived
@@ -42,12 +46,24 @@ public:
 public:
     QString computeExpr() const;
     bool isToplevelExpr() const;
+    /** the top-level expression of which this element is a part */
+    VarTree* topLevel();
     /** is this element an ancestor of (or equal to) child? */
     bool isAncestorEq(const VarTree* child) const;
     /** update the regular value; returns whether a repaint is necessary */
     bool updateValue(const QString& newValue);
     /** update the "quick member" value; returns whether repaint is necessary */
     bool updateStructValue(const QString& newValue);
+    /** tells whether the last update changed the value */
+    bool valueChanged() const { return m_baseChanged || m_structChanged; }
+    /** shows the value as unchanged */
+    void clearChanged();
+    /**
+     * Tells whether updating this item with \a v would only repeat the
+     * value, i.e. it is a simple value or a collapsed pointer without
+     * children and the value is the same.
+     */
+    bool isSameLeaf(const ExprValue* v) const;
     /** find out the type of this value using the child values */
     void inferTypesOfChildren(ProgramTypeTable& typeTable);
     /** get the type from base class part */
@@ -92,6 +108,15 @@ struct ExprValue
 
     void appendChild(ExprValue* newChild);
     int childCount() const;
+
+    /*
+     * Parsers create many ExprValues at once, and they are freed soon
+     * after. They are taken from a pool instead of the heap.
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* p);
+    /** The number of ExprValues created so far. */
+    static unsigned long allocations();
 };
 
 
@@ -116,6 +141,26 @@ signals:
 };
 
 
+/**
+ * Items that wait for an update. The items that the user can see are
+ * kept apart from the others, so that they can be taken first without
+ * searching. New items are classified when the next item is taken, and
+ * all items are classified again when the viewport changes.
+ */
+struct UpdateList
+{
+    std::list<VarTree*> visible;
+    std::list<VarTree*> offscreen;
+    std::list<VarTree*> unsorted;	//!< not classified yet
+
+    void push_back(VarTree* item) { unsorted.push_back(item); }
+    bool empty() const {
+	return visible.empty() && offscreen.empty() && unsorted.empty();
+    }
+    void clear() { visible.clear(); offscreen.clear(); unsorted.clear(); }
+};
+
+
 class ExprWnd : public QTreeWidget
 {
     Q_OBJECT
@@ -130,11 +175,14 @@ public:
     VarTree* insertExpr(ExprValue* expr, ProgramTypeTable& typeTable);
     /** updates an existing expression */
     void updateExpr(ExprValue* expr, ProgramTypeTable& typeTable);
-    void updateExpr(VarTree* display, ExprValue* newValues, ProgramTypeTable& typeTable);
+    /** returns whether a value in the tree changed */
+    bool updateExpr(VarTree* display, ExprValue* newValues, ProgramTypeTable& typeTable);
     /** updates the value and repaints it for a single item (not the children) */
     void updateSingleExpr(VarTree* display, ExprValue* newValues);
     /** updates only the value of the node */
     void updateStructValue(VarTree* display);
+    /** inserts array elements that start at \a start in front of \a more */
+    void insertArrayPage(VarTree* more, ExprValue* page, int start, ProgramTypeTable& typeTable);
     /** get a top-level expression by name */
     VarTree* topLevelExprByName(const QString& name) const;
     /** return a member of the struct that pointer \a v refers to */
@@ -143,12 +191,28 @@ public:
     static VarTree* memberByName(VarTree* v, const QString& name);
     /** removes an expression; must be on the topmost level*/
     void removeExpr(VarTree* item);
+    /** removes all expressions */
+    void clear();
+    /**
+     * Removes all expressions from the window, but does not delete them.
+     * The expanded items are appended to \a expanded.
+     */
+    QList<VarTree*> takeExprs(QList<VarTree*>& expanded);
+    /** re-inserts the expressions that takeExprs() returned */
+    void restoreExprs(const QList<VarTree*>& items, const QList<VarTree*>& expanded);
     /** clears the list of pointers needing updates */
     void clearPendingUpdates();
+    /** tells whether any items are waiting for an update */
+    bool hasPendingUpdates() const;
     /** returns a pointer to update (or 0) and removes it from the list */
     VarTree* nextUpdatePtr();
     VarTree* nextUpdateType();
     VarTree* nextUpdateStruct();
+    /**
+     * Tells whether \a item is currently shown in the viewport, i.e. its
+     * parents are expanded and it is not scrolled out of view.
+     */
+    bool isItemVisible(VarTree* item) const;
     void editValue(VarTree* item, const QString& text);
     /** tells whether the a value is currently edited */
     bool isEditing() const;
@@ -157,26 +221,57 @@ public:
     VarTree* topLevelItem(int i) const { return static_cast<VarTree*>(QTreeWidget::topLevelItem(i)); }
 
 protected:
-    void updateExprRec(VarTree* display, ExprValue* newValues, ProgramTypeTable& typeTable);
+    bool updateExprRec(VarTree* display, ExprValue* newValues, ProgramTypeTable& typeTable);
     void replaceChildren(VarTree* display, ExprValue* newValues);
+    static QList<QTreeWidgetItem*> makeItems(ExprValue* value);
+    static void expandInitially(VarTree* display, ExprValue* value);
     void collectUnknownTypes(VarTree* item);
     void checkUnknownType(VarTree* item);
     static QString formatWCharPointer(QString value);
     QPixmap m_pixPointer;
 
-    std::list<VarTree*> m_updatePtrs;	//!< dereferenced pointers that need update
-    std::list<VarTree*> m_updateType;	//!< structs whose type must be determined
-    std::list<VarTree*> m_updateStruct;	//!< structs whose nested value needs update
+    UpdateList m_updatePtrs;		//!< dereferenced pointers that need update
+    UpdateList m_updateType;		//!< structs whose type must be determined
+    UpdateList m_updateStruct;		//!< structs whose nested value needs update
+    /** removes the first visible item from \a list or else its front */
+    VarTree* takeNextUpdate(UpdateList& list);
+    /** moves the unclassified items of \a list to the visible or offscreen part */
+    void classifyUpdates(UpdateList& list) const;
+    QTimer m_viewportTimer;		//!< defers viewportChanged()
+    /** the top-level items by name, kept by insertExpr() and removeExpr() */
+    QMultiHash<QString,VarTree*> m_topLevelByName;
+    /** the top-level expressions that the last slotExprsChanged() reported as changed */
+    QSet<QString> m_changedExprs;
 
     ValueEdit* m_edit;
 
     /** remove items that are in the subTree from the list */
     void unhookSubtree(VarTree* subTree);
+    static void unhookSubtree(UpdateList& list, VarTree* subTree);
     static void unhookSubtree(std::list<VarTree*>& list, VarTree* subTree);
 
+public slots:
+    /**
+     * Receives the names of the top-level expressions that were added,
+     * removed, or changed by an update that left the other expressions
+     * alone. Only the expressions that were reported as changed the last
+     * time are shown as unchanged.
+     */
+    void slotExprsChanged(const QStringList& added, const QStringList& removed,
+			  const QStringList& changed);
+
+protected slots:
+    /** classifies the pending updates again after the viewport changed */
+    void slotReclassifyUpdates();
+
 signals:
     void removingItem(VarTree*);
     void editValueCommitted(VarTree*, const QString&);
+    /**
+     * This signal is emitted shortly after the user scrolled the window
+     * or expanded an item so that other items have come into view.
+     */
+    void viewportChanged();
 };
 
 #endif // EXPRWND_H
@@ -7,11 +7,13 @@
 #include "gdbdriver.h"
 #include "exprwnd.h"
 #include <QFileInfo>
+#include <QHash>
 #include <QRegExp>
 #include <QStringList>
 #include <klocale.h>			/* i18n */
 #include <ctype.h>
 #include <signal.h>
+#include <stdio.h>			/* sprintf */
 #include <stdlib.h>			/* strtol, atoi */
 #include <string.h>			/* strcpy */
 
@@ -30,9 +32,6 @@ static bool parseValueSeq(const char*& s, ExprValue* variable);
 #define PROMPT "(kdbg)"
 #define PROMPT_LEN 6
 
-// TODO: make this cmd info stuff non-static to allow multiple
-// simultaneous gdbs to run!
-
 struct GdbCmdInfo {
     DbgCommand cmd;
     const char* fmt;			/* format string */
@@ -61,9 +60,10 @@ static const char printQStringStructFmt[] = "print (0?\"%s\":$kdbgundef)\n";
 
 /*
  * The following array of commands must be sorted by the DC* values,
- * because they are used as indices.
+ * because they are used as indices. It is shared by all GdbDrivers;
+ * formats that depend on the particular gdb are kept in the driver.
  */
-static GdbCmdInfo cmds[] = {
+static const GdbCmdInfo cmds[] = {
     { DCinitialize, "", GdbCmdInfo::argNone },
     { DCtty, "tty %s\n", GdbCmdInfo::argString },
     { DCexecutable, "file \"%s\"\n", GdbCmdInfo::argString },
@@ -85,7 +85,7 @@ static GdbCmdInfo cmds[] = {
     { DCunsetenv, "unset env %s\n", GdbCmdInfo::argString },
     { DCsetoption, "setoption %s %d\n", GdbCmdInfo::argStringNum},
     { DCcd, "cd %s\n", GdbCmdInfo::argString },
-    { DCbt, "bt\n", GdbCmdInfo::argNone },
+    { DCbt, "bt %d\n", GdbCmdInfo::argNum },
     { DCrun, "run\n", GdbCmdInfo::argNone },
     { DCcont, "cont\n", GdbCmdInfo::argNone },
     { DCstep, "step\n", GdbCmdInfo::argNone },
@@ -120,13 +120,29 @@ static GdbCmdInfo cmds[] = {
     { DCignore, "ignore %d %d\n", GdbCmdInfo::argNum2},
     { DCprintWChar, "print ($s=%s)?*$s@wcslen($s):0x0\n", GdbCmdInfo::argString },
     { DCsetvariable, "set variable %s=%s\n", GdbCmdInfo::argString2 },
+    { DCprintStructBatch, "print %s\n", GdbCmdInfo::argString },
+    { DCprintPage, "print %s\n", GdbCmdInfo::argString },
+    { DCframelocals, "frame apply level %d -q kdbg__alllocals\n", GdbCmdInfo::argNum },
+    { DCbtall, "thread apply all bt\n", GdbCmdInfo::argNone },
+    { DCregistervalues, "info registers %s\n", GdbCmdInfo::argString },
+    { DCbreakbatch, "%s", GdbCmdInfo::argString },
+    { DClogpoint, "dprintf %s\n", GdbCmdInfo::argString },
+    { DCtargetcond, "set breakpoint condition-evaluation target\n", GdbCmdInfo::argNone },
+    { DCbtrange, "frame apply level %d-%d -q frame\n", GdbCmdInfo::argNum2 },
 };
 
 #define NUM_CMDS (int(sizeof(cmds)/sizeof(cmds[0])))
 #define MAX_FMTLEN 200
 
 GdbDriver::GdbDriver() :
-	DebuggerDriver()
+	DebuggerDriver(),
+	m_batchPrompts(0),
+	m_disassembleFmt(cmds[DCdisassemble].fmt),
+	m_haveFrameApply(false),
+	m_btFmt(cmds[DCbt].fmt),
+	m_btRangeFmt(cmds[DCbtrange].fmt),
+	m_btAllFmt(cmds[DCbtall].fmt),
+	m_printQStringFmt(printQStringStructFmt)
 {
 #ifndef NDEBUG
     // check command info array
@@ -219,12 +235,7 @@ QStringList GdbDriver::boolOptionList() const
     return QStringList();
 }
 
-bool GdbDriver::startup(QString cmdStr)
-{
-    if (!DebuggerDriver::startup(cmdStr))
-	return false;
-
-    static const char gdbInitialize[] =
+static const char gdbInitialize[] =
 	/*
 	 * Work around buggy gdbs that do command line editing even if they
 	 * are not on a tty. The readline library echos every command back
@@ -263,10 +274,27 @@ bool GdbDriver::startup(QString cmdStr)
 	"set prompt " PROMPT "\n"
 	;
 
-    executeCmdString(DCinitialize, gdbInitialize, false);
+const char* GdbDriver::initCommands() const
+{
+    return gdbInitialize;
+}
+
+bool GdbDriver::startup(QString cmdStr)
+{
+    if (!DebuggerDriver::startup(cmdStr))
+	return false;
+
+    /*
+     * Limit the number of array elements that are printed. This comes
+     * first, because the initialization commands end with the prompt
+     * that we synchronize with.
+     */
+    QString init;
+    init.sprintf("set print elements %d\n", m_arrayPageSize);
+    executeCmdString(DCinitialize, init + initCommands(), false);
 
     // assume that QString::null is ok
-    cmds[DCprintQStringStruct].fmt = printQStringStructFmt;
+    m_printQStringFmt = printQStringStructFmt;
 
     return true;
 }
@@ -281,36 +309,8 @@ void GdbDriver::commandFinished(CmdQueueItem* cmd)
 	return;
     }
 
-    switch (cmd->m_cmd) {
-    case DCinitialize:
-	{
-	    /*
-	     * Check for GDB 7.1 or later; the syntax for the disassemble
-	     * command has changed.
-	     * This RE picks the last version number in the first line,
-	     * because at least OpenSUSE writes its own version number
-	     * in the first line (but before GDB's version number).
-	     */
-	    QRegExp re(
-		" "			// must be preceded by space
-		"[(]?"			// SLES 10 embeds in parentheses
-		"(\\d+)\\.(\\d+)"	// major, minor
-		"[^ ]*\\n"		// no space until end of line
-		);
-	    int pos = re.indexIn(m_output);
-	    const char* disass = "disassemble %s %s\n";
-	    if (pos >= 0) {
-		int major = re.cap(1).toInt();
-		int minor = re.cap(2).toInt();
-		if (major > 7 || (major == 7 && minor >= 1))
-		{
-		    disass = "disassemble %s, %s\n";
-		}
-	    }
-	    cmds[DCdisassemble].fmt = disass;
-	}
-	break;
-    default:;
+    if (cmd->m_cmd == DCinitialize) {
+	parseGdbVersion(m_output);
     }
 
     /* ok, the command is ready */
@@ -335,8 +335,67 @@ void GdbDriver::commandFinished(CmdQueueItem* cmd)
     }
 }
 
-int GdbDriver::findPrompt(const QByteArray& output) const
+void GdbDriver::parseGdbVersion(const QByteArray& output)
+{
+    /*
+     * Check for GDB 7.1 or later; the syntax for the disassemble
+     * command has changed.
+     * This RE picks the last version number in the first line,
+     * because at least OpenSUSE writes its own version number
+     * in the first line (but before GDB's version number).
+     */
+    QRegExp re(
+	" "			// must be preceded by space
+	"[(]?"			// SLES 10 embeds in parentheses
+	"(\\d+)\\.(\\d+)"	// major, minor
+	"[^ ]*\\n"		// no space until end of line
+	);
+    int pos = re.indexIn(output);
+    const char* disass = "disassemble %s %s\n";
+    if (pos >= 0) {
+	int major = re.cap(1).toInt();
+	int minor = re.cap(2).toInt();
+	if (major > 7 || (major == 7 && minor >= 1))
+	{
+	    disass = "disassemble %s, %s\n";
+	}
+	// "frame apply" appeared in GDB 8.3
+	m_haveFrameApply = major > 8 || (major == 8 && minor >= 3);
+	// the arguments are shown only when a frame is selected
+	if (major >= 9) {
+	    m_btFmt = "bt -frame-arguments none %d\n";
+	    m_btRangeFmt = "with print frame-arguments none -- "
+			   "frame apply level %d-%d -q frame\n";
+	    m_btAllFmt = "thread apply all bt -frame-arguments none\n";
+	}
+    }
+    m_disassembleFmt = disass;
+}
+
+int GdbDriver::findPrompt(const QByteArray& output, int& scanned, int& promptEnd)
 {
+    int len = output.length();
+
+    /*
+     * A batch is done only after the prompt of its last line. Count the
+     * prompts in the output that arrived since we looked last time; a
+     * prompt may straddle the previous end.
+     */
+    if (m_activeCmd != 0 &&
+	(m_activeCmd->m_cmd == DCprintStructBatch || m_activeCmd->m_cmd == DCbreakbatch))
+    {
+	if (scanned == 0)
+	    m_batchPrompts = 0;
+	const char* p = output.constData() + qMax(scanned-PROMPT_LEN+1, 0);
+	while ((p = strstr(p, PROMPT)) != 0) {
+	    m_batchPrompts++;
+	    p += PROMPT_LEN;
+	}
+	scanned = len;
+	if (m_batchPrompts < m_activeCmd->m_cmdString.count('\n'))
+	    return -1;
+    }
+
     /*
      * If there's a prompt string in the collected output, it must be at
      * the very end.
@@ -348,15 +407,57 @@ int GdbDriver::findPrompt(const QByteArray& output) const
      * conditions for a very long time such that that buffer overflowed
      * exactly at the end of the prompt string look-a-like).
      */
-    int len = output.length();
     if (len >= PROMPT_LEN &&
 	strncmp(output.data()+len-PROMPT_LEN, PROMPT, PROMPT_LEN) == 0)
     {
+	promptEnd = len;
 	return len-PROMPT_LEN;
     }
     return -1;
 }
 
+const char GdbDriver::logpointTag[] = "kdbg-log: ";
+
+/*
+ * A logpoint prints with dprintf, and the program continues right away.
+ * Its lines are removed from the output as they arrive, so that the
+ * output of a long-running command does not grow with each hit. The
+ * remaining lines are moved down in place, a single pass for any number
+ * of hits.
+ */
+int GdbDriver::extractLogpointOutput(QByteArray& output, int start, QStringList& lines)
+{
+    char* data = output.data();
+    int len = output.length();
+    int src = start, dst = start;
+    const char* eol;
+    while ((eol = static_cast<const char*>(memchr(data+src, '\n', len-src))) != 0)
+    {
+	int next = eol+1 - data;
+	if (!logpointLine(data+src, next-1-src, lines)) {
+	    if (dst != src)
+		memmove(data+dst, data+src, next-src);
+	    dst += next-src;
+	}
+	src = next;
+    }
+    if (dst != src) {
+	// keep the incomplete line
+	memmove(data+dst, data+src, len-src);
+	output.resize(dst + len-src);
+    }
+    return dst;
+}
+
+bool GdbDriver::logpointLine(const char* line, int len, QStringList& lines)
+{
+    static const int tagLen = sizeof(logpointTag)-1;
+    if (len < tagLen || strncmp(line, logpointTag, tagLen) != 0)
+	return false;
+    lines.append(QString::fromLocal8Bit(line+tagLen, len-tagLen));
+    return true;
+}
+
 /*
  * The --fullname option makes gdb send a special normalized sequence print
  * each time the program stops and at some other points. The sequence has
@@ -416,6 +517,24 @@ static void normalizeStringArg(QString& arg)
 }
 
 
+const char* GdbDriver::cmdFormat(DbgCommand cmd) const
+{
+    switch (cmd) {
+    case DCdisassemble:
+	return m_disassembleFmt;
+    case DCbt:
+	return m_btFmt;
+    case DCbtrange:
+	return m_btRangeFmt;
+    case DCbtall:
+	return m_btAllFmt;
+    case DCprintQStringStruct:
+	return m_printQStringFmt.constData();
+    default:
+	return cmds[cmd].fmt;
+    }
+}
+
 QString GdbDriver::makeCmdString(DbgCommand cmd, QString strArg)
 {
     assert(cmd >= 0 && cmd < NUM_CMDS);
@@ -432,20 +551,47 @@ QString GdbDriver::makeCmdString(DbgCommand cmd, QString strArg)
 	 * arguments so that the user can override the redirections.
 	*/
 	strArg = m_redirect + " " + strArg;
+    } else if (cmd == DClogpoint) {
+	/*
+	 * Tag what the logpoint prints so that extractLogpointOutput()
+	 * can pick it out of the output. The format is the first quoted
+	 * argument.
+	 */
+	int quote = strArg.indexOf('"');
+	if (quote >= 0)
+	    strArg.insert(quote+1, logpointTag);
     }
 
     QString cmdString;
-    cmdString.sprintf(cmds[cmd].fmt, strArg.toUtf8().constData());
+    if (cmd == DCprintStructBatch) {
+	// the expressions are separated by newlines; print each of them
+	QStringList exprs = strArg.split('\n');
+	for (int i = 0; i < exprs.size(); i++) {
+	    QString line;
+	    line.sprintf(cmdFormat(cmd), exprs[i].toUtf8().constData());
+	    cmdString += line;
+	}
+	return cmdString;
+    }
+    cmdString.sprintf(cmdFormat(cmd), strArg.toUtf8().constData());
     return cmdString;
 }
 
+QString GdbDriver::commandString(DbgCommand cmd, QString strArg, int intArg)
+{
+    assert(cmd >= 0 && cmd < NUM_CMDS);
+    if (cmds[cmd].argsNeeded == GdbCmdInfo::argStringNum)
+	return makeCmdString(cmd, strArg, intArg);
+    return makeCmdString(cmd, strArg);
+}
+
 QString GdbDriver::makeCmdString(DbgCommand cmd, int intArg)
 {
     assert(cmd >= 0 && cmd < NUM_CMDS);
     assert(cmds[cmd].argsNeeded == GdbCmdInfo::argNum);
 
     QString cmdString;
-    cmdString.sprintf(cmds[cmd].fmt, intArg);
+    cmdString.sprintf(cmdFormat(cmd), intArg);
     return cmdString;
 }
 
@@ -541,11 +687,11 @@ QString GdbDriver::makeCmdString(DbgCommand cmd, QString strArg, int intArg)
 	    // must split off file name part
 	    strArg = QFileInfo(strArg).fileName();
 	}
-	cmdString.sprintf(cmds[cmd].fmt, strArg.toUtf8().constData(), intArg);
+	cmdString.sprintf(cmdFormat(cmd), strArg.toUtf8().constData(), intArg);
     }
     else
     {
-	cmdString.sprintf(cmds[cmd].fmt, intArg, strArg.toUtf8().constData());
+	cmdString.sprintf(cmdFormat(cmd), intArg, strArg.toUtf8().constData());
     }
     return cmdString;
 }
@@ -559,7 +705,7 @@ QString GdbDriver::makeCmdString(DbgCommand cmd, QString strArg1, QString strArg
     normalizeStringArg(strArg2);
 
     QString cmdString;
-    cmdString.sprintf(cmds[cmd].fmt,
+    cmdString.sprintf(cmdFormat(cmd),
 		      strArg1.toUtf8().constData(),
 		      strArg2.toUtf8().constData());
     return cmdString;
@@ -571,7 +717,7 @@ QString GdbDriver::makeCmdString(DbgCommand cmd, int intArg1, int intArg2)
     assert(cmds[cmd].argsNeeded == GdbCmdInfo::argNum2);
 
     QString cmdString;
-    cmdString.sprintf(cmds[cmd].fmt, intArg1, intArg2);
+    cmdString.sprintf(cmdFormat(cmd), intArg1, intArg2);
     return cmdString;
 }
 
@@ -584,7 +730,7 @@ CmdQueueItem* GdbDriver::executeCmd(DbgCommand cmd, bool clearLow)
 	m_haveCoreFile = false;
     }
 
-    return executeCmdString(cmd, cmds[cmd].fmt, clearLow);
+    return executeCmdString(cmd, cmdFormat(cmd), clearLow);
 }
 
 CmdQueueItem* GdbDriver::executeCmd(DbgCommand cmd, QString strArg,
@@ -620,7 +766,7 @@ CmdQueueItem* GdbDriver::executeCmd(DbgCommand cmd, int intArg1, int intArg2,
 
 CmdQueueItem* GdbDriver::queueCmd(DbgCommand cmd, QueueMode mode)
 {
-    return queueCmdString(cmd, cmds[cmd].fmt, mode);
+    return queueCmdString(cmd, cmdFormat(cmd), mode);
 }
 
 CmdQueueItem* GdbDriver::queueCmd(DbgCommand cmd, QString strArg,
@@ -647,6 +793,12 @@ CmdQueueItem* GdbDriver::queueCmd(DbgCommand cmd, QString strArg1, QString strAr
     return queueCmdString(cmd, makeCmdString(cmd, strArg1, strArg2), mode);
 }
 
+CmdQueueItem* GdbDriver::queueCmd(DbgCommand cmd, int intArg1, int intArg2,
+				  QueueMode mode)
+{
+    return queueCmdString(cmd, makeCmdString(cmd, intArg1, intArg2), mode);
+}
+
 void GdbDriver::terminate()
 {
     ::kill(pid(), SIGTERM);
@@ -737,7 +889,7 @@ void GdbDriver::setPrintQStringDataCmd(const char* cmd)
     if (cmd == 0 || *cmd == '\0')
 	return;
     assert(strlen(cmd) <= MAX_FMTLEN);
-    cmds[DCprintQStringStruct].fmt = cmd;
+    m_printQStringFmt = cmd;
 }
 
 ExprValue* GdbDriver::parseQCharArray(const char* output, bool wantErrorValue, bool qt3like)
@@ -1163,6 +1315,31 @@ inline void skipName(const char*& p)
 	p++;
 }
 
+/*
+ * The same member names and array indexes occur over and over in the
+ * values that are printed. They are looked up here so that equal names
+ * share their string data instead of being allocated for each value.
+ */
+static QString internName(const char* s, int len)
+{
+    static QHash<QByteArray, QString> names;
+    QHash<QByteArray, QString>::const_iterator i = names.find(QByteArray::fromRawData(s, len));
+    if (i != names.end())
+	return *i;
+    QString name = QString::fromLatin1(s, len);
+    // don't let the table grow without bounds
+    if (names.size() < 10000)
+	names.insert(QByteArray(s, len), name);
+    return name;
+}
+
+static QString arrayIndexName(int index)
+{
+    char buf[16];
+    int len = sprintf(buf, "[%d]", index);
+    return internName(buf, len);
+}
+
 static bool parseName(const char*& s, QString& name, VarTree::NameKind& kind)
 {
     kind = VarTree::NKplain;
@@ -1201,7 +1378,7 @@ static bool parseName(const char*& s, QString& name, VarTree::NameKind& kind)
 	    }
 	    len = p - s;
 	}
-	name = QString::fromLatin1(s, len);
+	name = internName(s, len);
     }
     // return the new position
     s = p;
@@ -1211,6 +1388,7 @@ static bool parseName(const char*& s, QString& name, VarTree::NameKind& kind)
 static bool parseValue(const char*& s, ExprValue* variable)
 {
     variable->m_value = "";
+    bool printer = false;		/* the elements follow a summary */
 
 repeat:
     if (*s == '{') {
@@ -1245,6 +1423,19 @@ repeat:
 	    // final white space
 	    while (isspace(*s))
 		s++;
+	    /*
+	     * The elements of a container cannot be fetched by index like
+	     * those of an array, so the suppressed ones cannot be paged in.
+	     */
+	    if (printer) {
+		ExprValue* last = variable->m_child;
+		while (last != 0 && last->m_next != 0)
+		    last = last->m_next;
+		if (last != 0 && last->m_nameKind == VarTree::NKmore) {
+		    last->m_nameKind = VarTree::NKplain;
+		    last->m_value = i18n("<additional entries of the container suppressed>");
+		}
+	    }
 	}
     }
     // Sometimes we find a warning; it ends at the next LF
@@ -1401,6 +1592,24 @@ repeat:
 		if (isAnonNS)
 		    goto moreEnum;
 	    }
+	    /*
+	     * A pretty-printer may print a summary in front of the
+	     * elements of a container, e.g.
+	     *  std::vector of length 3, capacity 3 = {1, 2, 3}
+	     *  std::__cxx11::list = {[0] = 1}
+	     */
+	    const char* q = p;
+	    if (*q == ' ' && isalpha(q[1])) {
+		while (*q != '\0' && *q != '\n' && *q != '{' && *q != '}' &&
+		       *q != '"' && strncmp(q, " = {", 4) != 0)
+		    q++;
+	    }
+	    if (strncmp(q, " = {", 4) == 0) {
+		variable->m_value += QString::fromLatin1(start, q - start);
+		printer = true;
+		s = q + 3;		/* the opening brace */
+		goto repeat;
+	    }
 	}
 	variable->m_value += QString::fromLatin1(start, p - start);
 
@@ -1506,6 +1715,7 @@ static bool parseVarSeq(const char*& s, ExprValue* variable)
 {
     // parse a comma-separated sequence of variables
     ExprValue* var = variable;		/* var != 0 to indicate success if empty seq */
+    ExprValue* last = 0;		/* do not walk the chain of children */
     for (;;) {
 	if (*s == '}')
 	    break;
@@ -1518,7 +1728,11 @@ static bool parseVarSeq(const char*& s, ExprValue* variable)
 	var = parseVar(s);
 	if (var == 0)
 	    break;			/* syntax error */
-	variable->appendChild(var);
+	if (last == 0)
+	    variable->appendChild(var);
+	else
+	    last->m_next = var;
+	last = var;
 	if (*s != ',')
 	    break;
 	// skip the comma and whitespace
@@ -1534,9 +1748,9 @@ static bool parseValueSeq(const char*& s, ExprValue* variable)
     // parse a comma-separated sequence of variables
     int index = 0;
     bool good;
+    ExprValue* last = 0;		/* do not walk the chain of children */
     for (;;) {
-	QString name;
-	name.sprintf("[%d]", index);
+	QString name = arrayIndexName(index);
 	ExprValue* var = new ExprValue(name, VarTree::NKplain);
 	good = parseValue(s, var);
 	if (!good) {
@@ -1566,13 +1780,17 @@ static bool parseValueSeq(const char*& s, ExprValue* variable)
 	} else {
 	    index++;
 	}
-	variable->appendChild(var);
+	if (last == 0)
+	    variable->appendChild(var);
+	else
+	    last->m_next = var;
+	last = var;
 	// long arrays may be terminated by '...'
 	if (strncmp(s, "...", 3) == 0) {
 	    s += 3;
-	    ExprValue* var = new ExprValue("...", VarTree::NKplain);
+	    ExprValue* var = new ExprValue("...", VarTree::NKmore);
 	    var->m_value = i18n("<additional entries of the array suppressed>");
-	    variable->appendChild(var);
+	    last->m_next = var;
 	    break;
 	}
 	if (*s != ',') {
@@ -1785,13 +2003,21 @@ static bool parseFrame(const char*& s, int& frameNo, QString& func,
     return true;
 }
 
-void GdbDriver::parseBackTrace(const char* output, std::list<StackFrame>& stack)
+bool GdbDriver::parseBackTrace(const char* output, std::list<StackFrame>& stack)
 {
     QString func, file;
     int lineNo, frameNo;
     DbgAddr address;
+    const char* start = output;
 
-    while (::parseFrame(output, frameNo, func, file, lineNo, address)) {
+    for (;;) {
+	// frame apply prints the source line after each frame
+	while (*output != '\0' && *output != '#') {
+	    const char* end = strchr(output, '\n');
+	    output = end != 0 ? end+1 : output + strlen(output);
+	}
+	if (!::parseFrame(output, frameNo, func, file, lineNo, address))
+	    break;
 	stack.push_back(StackFrame());
 	StackFrame* frm = &stack.back();
 	frm->frameNo = frameNo;
@@ -1800,6 +2026,8 @@ void GdbDriver::parseBackTrace(const char* output, std::list<StackFrame>& stack)
 	frm->address = address;
 	frm->var = new ExprValue(func, VarTree::NKplain);
     }
+    // bt N ends with this line if the stack is deeper
+    return strstr(start, "(More stack frames follow") != 0;
 }
 
 bool GdbDriver::parseFrameChange(const char* output, int& frameNo,
@@ -1840,6 +2068,9 @@ bool GdbDriver::parseBreakList(const char* output, std::list<Breakpoint>& brks)
 		p++;
 	    if (strncmp(p, "breakpoint", 10) == 0) {
 		p += 10;
+	    } else if (strncmp(p, "dprintf", 7) == 0) {
+		bp.type = Breakpoint::logpoint;
+		p += 7;
 	    } else if (strncmp(p, "hw watchpoint", 13) == 0) {
 		bp.type = Breakpoint::watchpoint;
 		p += 13;
@@ -1869,7 +2100,7 @@ bool GdbDriver::parseBreakList(const char* output, std::list<Breakpoint>& brks)
 	if (*p == '\0')
 	    break;
 	// the address, if present
-	if (bp.type == Breakpoint::breakpoint &&
+	if (bp.type != Breakpoint::watchpoint &&
 	    strncmp(p, "0x", 2) == 0)
 	{
 	    const char* start = p;
@@ -1913,12 +2144,22 @@ bool GdbDriver::parseBreakList(const char* output, std::list<Breakpoint>& brks)
 		// extract condition
 		p += 13;
 		bp.condition = QString::fromLatin1(p, end-p).trimmed();
+		// gdb tells who evaluates it unless it decides itself
+		if (bp.condition.endsWith(" (target evals)")) {
+		    bp.condTarget = true;
+		    bp.condition.chop(15);
+		} else if (bp.condition.endsWith(" (host evals)")) {
+		    bp.condition.chop(13);
+		}
 		TRACE("condition: "+bp.condition);
 	    } else if (strncmp(p, "ignore next ", 12) == 0) {
 		// extract ignore count
 		p += 12;
 		bp.ignoreCount = strtol(p, &dummy, 10);
 		TRACE(QString("ignore count %1").arg(bp.ignoreCount));
+	    } else if (bp.type == Breakpoint::logpoint &&
+		       strncmp(p, "printf ", 7) == 0) {
+		// the format of a logpoint; we know it already
 	    } else {
 		// indeed a continuation
 		bp.location += " " + QString::fromLatin1(p, end-p).trimmed();
@@ -2056,6 +2297,54 @@ std::list<ThreadInfo> GdbDriver::parseThreadList(const char* output)
     return threads;
 }
 
+std::list<ThreadStack> GdbDriver::parseThreadStacks(const char* output)
+{
+    // Example:
+    //
+    //   Thread 2 (Thread 0x7ffff7854700 (LWP 10827) "thrserver"):
+    //   #0  0x00007ffff7928631 in clone () from /lib64/libc.so.6
+    //
+    //   Thread 1 (Thread 0x7ffff7fcc700 (LWP 10808) "thrserver"):
+    //   #0  main () at thrserver.c:84
+    std::list<ThreadStack> stacks;
+    const char* p = output;
+    while (*p != '\0') {
+	while (isspace(*p))
+	    p++;
+	if (strncmp(p, "Thread ", 7) != 0 || !isdigit(p[7])) {
+	    // not a thread header; skip the line
+	    p = strchr(p, '\n');
+	    if (p == 0)
+		break;
+	    continue;
+	}
+	ThreadStack stack;
+	stack.id = atoi(p+7);
+	const char* eol = strchr(p, '\n');
+	if (eol == 0)
+	    eol = p + strlen(p);
+	// the SYSTAG is enclosed in the outermost parentheses
+	const char* start = static_cast<const char*>(memchr(p, '(', eol-p));
+	const char* end = eol;
+	while (end > p && end[-1] != ')')
+	    --end;
+	if (start != 0 && end > start+1)
+	    stack.threadName = QString::fromLatin1(start+1, end-start-2);
+	p = eol;
+	while (isspace(*p))
+	    p++;
+
+	ThreadFrame frm;
+	while (::parseFrame(p, frm.frameNo, frm.function,
+			    frm.fileName, frm.lineNo, frm.address))
+	{
+	    stack.frames.push_back(frm);
+	}
+	stacks.push_back(stack);
+    }
+    return stacks;
+}
+
 static bool parseNewBreakpoint(const char* o, int& id,
 			       QString& file, int& lineNo, QString& address);
 static bool parseNewWatchpoint(const char* o, int& id,
@@ -2080,6 +2369,9 @@ bool GdbDriver::parseBreakpoint(const char* output, int& id,
     } else if (strncmp(output, "Temporary breakpoint ", 21) == 0) {
 	output += 21;
 	return ::parseNewBreakpoint(output, id, file, lineNo, address);
+    } else if (strncmp(output, "Dprintf ", 8) == 0) {
+	output += 8;
+	return ::parseNewBreakpoint(output, id, file, lineNo, address);
     } else if (strncmp(output, "Hardware watchpoint ", 20) == 0) {
 	output += 20;
 	return ::parseNewWatchpoint(output, id, address);
@@ -2218,6 +2510,30 @@ ExprValue* GdbDriver::parsePrintExpr(const char* output, bool wantErrorValue)
     return var;
 }
 
+std::list<QByteArray> GdbDriver::parseBatchOutput(const char* output)
+{
+    // the output of each line but the last one ends with the prompt
+    std::list<QByteArray> parts;
+    const char* p = output;
+    const char* end;
+    while ((end = strstr(p, PROMPT)) != 0) {
+	parts.push_back(QByteArray(p, end-p));
+	p = end + PROMPT_LEN;
+    }
+    parts.push_back(QByteArray(p));
+    return parts;
+}
+
+ExprValue* GdbDriver::parseValueString(const QString& name, const char* value)
+{
+    ExprValue* var = new ExprValue(name, VarTree::NKplain);
+    if (!parseValue(value, var)) {
+	delete var;
+	return 0;
+    }
+    return var;
+}
+
 bool GdbDriver::parseChangeWD(const char* output, QString& message)
 {
     bool isGood = false;
@@ -20,6 +20,8 @@ public:
     virtual QString driverName() const;
     virtual QString defaultInvocation() const;
     virtual QStringList boolOptionList() const;
+    virtual bool canListFrameLocals() const { return m_haveFrameApply; }
+    virtual bool canListFrameRange() const { return m_haveFrameApply; }
     void setDefaultInvocation(QString cmd) { m_defaultCmd = cmd; }
     static QString defaultGdb();
     virtual bool startup(QString cmdStr);
@@ -46,21 +48,27 @@ public:
 				   QueueMode mode);
     virtual CmdQueueItem* queueCmd(DbgCommand, QString strArg1, QString strArg2,
 				   QueueMode mode);
+    virtual CmdQueueItem* queueCmd(DbgCommand, int intArg1, int intArg2,
+				   QueueMode mode);
 
     virtual void terminate();
     virtual void detachAndTerminate();
     virtual void interruptInferior();
     virtual void setPrintQStringDataCmd(const char* cmd);
     virtual ExprValue* parseQCharArray(const char* output, bool wantErrorValue, bool qt3like);
-    virtual void parseBackTrace(const char* output, std::list<StackFrame>& stack);
+    virtual bool parseBackTrace(const char* output, std::list<StackFrame>& stack);
     virtual bool parseFrameChange(const char* output, int& frameNo,
 				  QString& file, int& lineNo, DbgAddr& address);
     virtual bool parseBreakList(const char* output, std::list<Breakpoint>& brks);
     virtual std::list<ThreadInfo> parseThreadList(const char* output);
+    virtual std::list<ThreadStack> parseThreadStacks(const char* output);
+    virtual bool canBatchBreakpoints() const { return true; }
+    virtual QString commandString(DbgCommand cmd, QString strArg, int intArg);
     virtual bool parseBreakpoint(const char* output, int& id,
 				 QString& file, int& lineNo, QString& address);
     virtual void parseLocals(const char* output, std::list<ExprValue*>& newVars);
     virtual ExprValue* parsePrintExpr(const char* output, bool wantErrorValue);
+    virtual std::list<QByteArray> parseBatchOutput(const char* output);
     virtual bool parseChangeWD(const char* output, QString& message);
     virtual bool parseChangeExecutable(const char* output, QString& message);
     virtual bool parseCoreFile(const char* output);
@@ -79,14 +87,50 @@ protected:
     QString m_redirect;			/* redirection to /dev/null */
     bool m_haveCoreFile;
     QString m_defaultCmd;		/* how to invoke gdb */
+    int m_batchPrompts;			/* prompts seen by findPrompt() */
+    const char* m_disassembleFmt;	/* depends on the gdb version */
+    bool m_haveFrameApply;		/* ditto */
+    const char* m_btFmt;		/* ditto */
+    const char* m_btRangeFmt;		/* ditto */
+    const char* m_btAllFmt;		/* ditto */
+    QByteArray m_printQStringFmt;	/* depends on the Qt version */
 
     QString makeCmdString(DbgCommand cmd, QString strArg);
     QString makeCmdString(DbgCommand cmd, int intArg);
     QString makeCmdString(DbgCommand cmd, QString strArg, int intArg);
     QString makeCmdString(DbgCommand cmd, QString strArg1, QString strArg2);
     QString makeCmdString(DbgCommand cmd, int intArg1, int intArg2);
-    virtual int findPrompt(const QByteArray& output) const;
+    /**
+     * Returns the commands that are sent to gdb right after it started.
+     */
+    virtual const char* initCommands() const;
+    /**
+     * Returns the format string of the command \a cmd.
+     */
+    virtual const char* cmdFormat(DbgCommand cmd) const;
+    virtual int findPrompt(const QByteArray& output, int& scanned, int& promptEnd);
+    virtual int extractLogpointOutput(QByteArray& output, int start, QStringList& lines);
+    /**
+     * Tells whether the line of \a len characters at \a line was printed
+     * by a logpoint and appends its text to \a lines if so.
+     */
+    virtual bool logpointLine(const char* line, int len, QStringList& lines);
+    /**
+     * The text that precedes the output of each logpoint.
+     */
+    static const char logpointTag[];
     void parseMarker(CmdQueueItem* cmd);
+    /**
+     * Adjusts the command formats to the gdb version that is announced
+     * in the startup banner.
+     */
+    void parseGdbVersion(const QByteArray& output);
+    /**
+     * Parses a value in gdb's print syntax, e.g. the value part of the
+     * output of the print command, and gives it the specified name.
+     * @return 0 if the value could not be parsed.
+     */
+    static ExprValue* parseValueString(const QString& name, const char* value);
 };
 
 #endif // GDBDRIVER_H
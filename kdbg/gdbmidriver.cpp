@@ -0,0 +1,991 @@
+/*
+ * Copyright Johannes Sixt
+ * This file is licensed under the GNU General Public License Version 2.
+ * See the file COPYING in the toplevel directory of the source directory.
+ */
+
+#include "gdbmidriver.h"
+#include "exprwnd.h"
+#include <QList>
+#include <QSet>
+#include <ctype.h>
+#include <stdlib.h>			/* atoi */
+#include <string.h>			/* strncmp */
+#include <map>
+#include <vector>
+
+#include "assert.h"
+#include "mydebug.h"
+
+#define MI_PROMPT "(gdb) \n"
+#define MI_PROMPT_LEN 7
+// terminates the output of each line of a batch
+#define BATCH_SEPARATOR '\032'
+
+struct GdbMICmdInfo {
+    DbgCommand cmd;
+    const char* fmt;			/* format string; 0 = use GdbDriver's */
+};
+
+/*
+ * The following array of commands must be sorted by the DC* values,
+ * because they are used as indices.
+ *
+ * Commands that do not have an MI format are handed to the CLI
+ * interpreter; they must take the same arguments as in GdbDriver.
+ * Commands that consist of several lines must produce one result record
+ * per line.
+ */
+static const GdbMICmdInfo cmds[] = {
+    { DCinitialize, 0 },
+    { DCtty, 0 },
+    { DCexecutable, 0 },
+    { DCtargetremote, 0 },
+    { DCcorefile, 0 },
+    { DCattach, 0 },
+    { DCinfolinemain, "list main\n-file-list-exec-source-file\n" },
+    { DCinfolocals, "-stack-list-variables --all-values\n" },
+    { DCinforegisters, "-data-list-register-names\n"
+		       "-data-list-register-values x\n"
+		       "-data-list-register-values N\n" },
+    { DCexamine, 0 },
+    { DCinfoline, 0 },
+    { DCdisassemble, 0 },
+    { DCsetargs, 0 },
+    { DCsetenv, 0 },
+    { DCunsetenv, 0 },
+    { DCsetoption, 0 },
+    { DCcd, 0 },
+    { DCbt, "-stack-list-frames 0 %d\n" },
+    { DCrun, "-exec-run\n" },
+    { DCcont, "-exec-continue\n" },
+    { DCstep, "-exec-step\n" },
+    { DCstepi, "-exec-step-instruction\n" },
+    { DCnext, "-exec-next\n" },
+    { DCnexti, "-exec-next-instruction\n" },
+    { DCfinish, "-exec-finish\n" },
+    { DCuntil, "-exec-until %s:%d\n" },
+    { DCkill, 0 },
+    { DCbreaktext, 0 },
+    { DCbreakline, "-break-insert %s:%d\n" },
+    { DCtbreakline, "-break-insert -t %s:%d\n" },
+    { DCbreakaddr, "-break-insert *%s\n" },
+    { DCtbreakaddr, "-break-insert -t *%s\n" },
+    { DCwatchpoint, 0 },		/* MI wants the expression as one word */
+    { DCdelete, "-break-delete %d\n" },
+    { DCenable, "-break-enable %d\n" },
+    { DCdisable, "-break-disable %d\n" },
+    { DCprint, 0 },
+    { DCprintDeref, 0 },
+    { DCprintStruct, 0 },
+    { DCprintQStringStruct, 0 },
+    { DCprintPopup, 0 },
+    { DCframe, "-stack-select-frame %d\n-stack-info-frame\n" },
+    { DCfindType, 0 },
+    { DCinfosharedlib, 0 },
+    { DCthread, "-thread-select %d\n" },
+    { DCinfothreads, "-thread-info\n" },
+    { DCinfobreak, "-break-list\n" },
+    { DCcondition, 0 },			/* MI wants the condition as one word */
+    { DCsetpc, 0 },
+    { DCignore, "-break-after %d %d\n" },
+    { DCprintWChar, 0 },
+    { DCsetvariable, 0 },
+    { DCprintStructBatch, 0 },
+    { DCprintPage, 0 },
+    { DCframelocals, "-stack-list-variables --frame %d --all-values\n" },
+    { DCbtall, 0 },
+    { DCregistervalues, 0 },
+    { DCbreakbatch, 0 },
+    { DClogpoint, 0 },			/* dprintf needs the CLI syntax */
+    { DCtargetcond, 0 },
+    { DCbtrange, "-stack-list-frames %d %d\n" },
+};
+
+#define NUM_CMDS (int(sizeof(cmds)/sizeof(cmds[0])))
+
+static const char gdbMIInitialize[] =
+	"-gdb-set confirm off\n"
+	"-gdb-set print static-members off\n"
+	"-gdb-set print asm-demangle on\n"
+	"-gdb-set print thread-events off\n"
+	/*
+	 * Don't assume that program functions invoked from a watch expression
+	 * always succeed.
+	 */
+	"-gdb-set unwindonsignal on\n"
+	;
+
+
+/*
+ * A node of a parsed MI record. A const carries its unescaped c-string
+ * in m_value; the elements of a tuple or a list are linked through
+ * m_child and m_next. Results have a name, list elements may not.
+ */
+struct MIValue
+{
+    QByteArray m_name;
+    QByteArray m_value;
+    MIValue* m_child;
+    MIValue* m_next;
+
+    MIValue() : m_child(0), m_next(0) { }
+    ~MIValue();
+    const MIValue* find(const char* name) const;
+    QString str(const char* name) const;
+    int num(const char* name, int defValue) const;
+};
+
+MIValue::~MIValue()
+{
+    delete m_child;
+    // lists can be very long; don't recurse along the siblings
+    while (m_next != 0) {
+	MIValue* n = m_next;
+	m_next = n->m_next;
+	n->m_next = 0;
+	delete n;
+    }
+}
+
+const MIValue* MIValue::find(const char* name) const
+{
+    for (const MIValue* v = m_child; v != 0; v = v->m_next) {
+	if (v->m_name == name)
+	    return v;
+    }
+    return 0;
+}
+
+QString MIValue::str(const char* name) const
+{
+    const MIValue* v = find(name);
+    return v ? QString::fromLatin1(v->m_value) : QString();
+}
+
+int MIValue::num(const char* name, int defValue) const
+{
+    const MIValue* v = find(name);
+    bool ok = false;
+    int n = v ? v->m_value.toInt(&ok) : 0;
+    return ok ? n : defValue;
+}
+
+/*
+ * Appends the contents of the c-string that starts at p to out and
+ * advances p past the closing quote.
+ */
+static void parseCString(const char*& p, QByteArray& out)
+{
+    ASSERT(*p == '"');
+    p++;
+    while (*p != '\0' && *p != '"') {
+	if (*p != '\\' || p[1] == '\0') {
+	    out += *p++;
+	    continue;
+	}
+	p++;
+	switch (*p) {
+	case 'n': out += '\n'; p++; break;
+	case 't': out += '\t'; p++; break;
+	case 'r': out += '\r'; p++; break;
+	case 'f': out += '\f'; p++; break;
+	case 'e': out += '\033'; p++; break;
+	case '0': case '1': case '2': case '3':
+	case '4': case '5': case '6': case '7':
+	    {
+		int c = 0;
+		for (int i = 0; i < 3 && *p >= '0' && *p <= '7'; i++, p++)
+		    c = c*8 + (*p - '0');
+		out += char(c);
+	    }
+	    break;
+	default:			/* \" and \\ */
+	    out += *p++;
+	    break;
+	}
+    }
+    if (*p == '"')
+	p++;
+}
+
+static MIValue* parseMIResult(const char*& p);
+
+/*
+ * Parses a const, a tuple, or a list.
+ */
+static MIValue* parseMIValue(const char*& p)
+{
+    MIValue* value = new MIValue;
+    if (*p == '"') {
+	parseCString(p, value->m_value);
+	return value;
+    }
+    if (*p != '{' && *p != '[') {
+	delete value;
+	return 0;
+    }
+    char closing = *p == '{' ? '}' : ']';
+    p++;
+    MIValue** tail = &value->m_child;
+    while (*p != closing) {
+	// list elements may be values without a name
+	MIValue* elem;
+	if (*p == '"' || *p == '{' || *p == '[')
+	    elem = parseMIValue(p);
+	else
+	    elem = parseMIResult(p);
+	if (elem == 0) {
+	    delete value;
+	    return 0;
+	}
+	*tail = elem;
+	tail = &elem->m_next;
+	if (*p == ',')
+	    p++;
+	else if (*p != closing) {
+	    delete value;
+	    return 0;
+	}
+    }
+    p++;				/* skip closing bracket */
+    return value;
+}
+
+static MIValue* parseMIResult(const char*& p)
+{
+    const char* start = p;
+    while (*p != '\0' && *p != '=' && *p != '\n')
+	p++;
+    if (*p != '=')
+	return 0;
+    QByteArray name(start, p-start);
+    p++;
+    MIValue* value = parseMIValue(p);
+    if (value != 0)
+	value->m_name = name;
+    return value;
+}
+
+/*
+ * Parses the results of a record; p points after the record class. The
+ * results become the children of the returned tuple. Parsing stops at
+ * the first syntax error.
+ */
+static MIValue* parseMIRecord(const char* p)
+{
+    MIValue* record = new MIValue;
+    MIValue** tail = &record->m_child;
+    while (*p == ',') {
+	p++;
+	MIValue* result = parseMIResult(p);
+	if (result == 0)
+	    break;
+	*tail = result;
+	tail = &result->m_next;
+    }
+    return record;
+}
+
+/*
+ * Finds the line in the output that starts with the record prefix, e.g.
+ * "*stopped", and returns a pointer to the character after the prefix.
+ */
+static const char* findMIRecord(const char* output, const char* prefix, int skip = 0)
+{
+    int len = strlen(prefix);
+    const char* p = output;
+    while (p != 0 && *p != '\0') {
+	if (strncmp(p, prefix, len) == 0 &&
+	    (p[len] == ',' || p[len] == '\n' || p[len] == '\0'))
+	{
+	    if (skip-- == 0)
+		return p + len;
+	}
+	p = strchr(p, '\n');
+	if (p != 0)
+	    p++;
+    }
+    return 0;
+}
+
+/*
+ * Searches the "^done" result records in the output for the one that has
+ * a result with the specified name. skip specifies how many such records
+ * are to be skipped.
+ * @return the parsed record or 0 if there is none.
+ */
+static MIValue* parseDoneRecord(const char* output, const char* name, int skip = 0)
+{
+    const char* p;
+    for (int i = 0; (p = findMIRecord(output, "^done", i)) != 0; i++) {
+	MIValue* record = parseMIRecord(p);
+	if (record->find(name) != 0 && skip-- == 0)
+	    return record;
+	delete record;
+    }
+    return 0;
+}
+
+/*
+ * Extracts the location of a frame tuple. The function name is decorated
+ * in the same way as in the CLI's backtrace.
+ */
+static void parseMIFrame(const MIValue* frame, QString& func,
+			 QString& file, int& lineNo, DbgAddr& address)
+{
+    func = frame->str("func");
+    if (func.isEmpty())
+	func = "??";
+    file = frame->str("fullname");
+    if (file.isEmpty())
+	file = frame->str("file");
+    lineNo = frame->num("line", 0) - 1;
+    address = frame->str("addr");
+
+    if (!file.isEmpty() && lineNo >= 0) {
+	func += " at " + frame->str("file") + ":" + frame->str("line");
+    } else {
+	file = QString();
+	lineNo = -1;
+	QString from = frame->str("from");
+	if (!from.isEmpty())
+	    func += " from " + from;
+    }
+}
+
+
+GdbMIDriver::GdbMIDriver() :
+	GdbDriver(),
+	m_scanResults(0),
+	m_scanRunning(false)
+{
+#ifndef NDEBUG
+    // check command info array
+    for (int i = 0; i < NUM_CMDS; i++) {
+	// must be indexable by DbgCommand values, i.e. sorted by DbgCommand values
+	assert(i == cmds[i].cmd);
+	// MI formats must take the same arguments as the CLI formats
+	if (cmds[i].fmt != 0) {
+	    const char* cli = GdbDriver::cmdFormat(DbgCommand(i));
+	    const char* p = cmds[i].fmt;
+	    const char* q = cli;
+	    while ((p = strchr(p, '%')) != 0) {
+		q = strchr(q, '%');
+		assert(q != 0 && p[1] == q[1]);
+		p += 2;
+		q += 2;
+	    }
+	    assert(strchr(q, '%') == 0);
+	}
+    }
+#endif
+}
+
+GdbMIDriver::~GdbMIDriver()
+{
+}
+
+
+QString GdbMIDriver::driverName() const
+{
+    return "GDBMI";
+}
+
+QString GdbMIDriver::defaultGdbMI()
+{
+    return
+	"gdb"
+	" --interpreter=mi2"
+	" --nx";	/* do not execute initialization files */
+}
+
+QString GdbMIDriver::defaultInvocation() const
+{
+    if (m_defaultCmd.isEmpty()) {
+	return defaultGdbMI();
+    } else {
+	return m_defaultCmd;
+    }
+}
+
+bool GdbMIDriver::startup(QString cmdStr)
+{
+    if (cmdStr.isEmpty())
+	cmdStr = defaultInvocation();
+
+    // the user's gdb command may not ask for the machine interface
+    if (!cmdStr.contains("--interpreter"))
+	cmdStr += " --interpreter=mi2";
+
+    return GdbDriver::startup(cmdStr);
+}
+
+const char* GdbMIDriver::initCommands() const
+{
+    return gdbMIInitialize;
+}
+
+const char* GdbMIDriver::cmdFormat(DbgCommand cmd) const
+{
+    assert(cmd >= 0 && cmd < NUM_CMDS);
+    if (cmds[cmd].fmt != 0)
+	return cmds[cmd].fmt;
+    return GdbDriver::cmdFormat(cmd);
+}
+
+int GdbMIDriver::findPrompt(const QByteArray& output, int& scanned, int& promptEnd)
+{
+    const char* data = output.constData();
+
+    // an interrupted command is done with the prompt at the very end
+    if (m_activeCmd == 0) {
+	int start = output.length() - MI_PROMPT_LEN;
+	if (start >= 0 &&
+	    strncmp(data+start, MI_PROMPT, MI_PROMPT_LEN) == 0 &&
+	    (start == 0 || data[start-1] == '\n'))
+	{
+	    promptEnd = output.length();
+	    return start;
+	}
+	return -1;
+    }
+
+    /*
+     * gdb prints a prompt after each result record, but also after the
+     * banner and after "^running". The output of the active command ends
+     * with the first prompt after there is a result record with its token
+     * for each line that we sent and the program has stopped again.
+     * Anything that follows belongs to commands that were sent ahead.
+     *
+     * Only complete lines are examined, and each of them only once.
+     */
+    if (scanned == 0) {
+	m_scanResults = 0;
+	m_scanRunning = false;
+    }
+    int expected = m_activeCmd->m_cmdString.count('\n');
+    const char* p = data + scanned;
+    const char* eol;
+    while ((eol = strchr(p, '\n')) != 0)
+    {
+	const char* r = p;
+	int token = 0;
+	while (isdigit(*r))
+	    token = token*10 + *r++ - '0';
+	if (*r == '^') {
+	    if (token == m_activeCmd->m_token) {
+		m_scanResults++;
+		m_scanRunning = strncmp(r, "^running", 8) == 0;
+	    }
+	} else if (strncmp(r, "*stopped", 8) == 0) {
+	    m_scanRunning = false;
+	} else if (m_scanResults >= expected && !m_scanRunning &&
+		   strncmp(p, MI_PROMPT, MI_PROMPT_LEN) == 0)
+	{
+	    scanned = p - data;
+	    promptEnd = eol+1 - data;
+	    return p - data;
+	}
+	p = eol+1;
+    }
+    scanned = p - data;
+    return -1;
+}
+
+QByteArray GdbMIDriver::commandText(const CmdQueueItem* cmd) const
+{
+    // every line carries the token, so that we find the result records
+    QByteArray token = QByteArray::number(cmd->m_token);
+    QList<QByteArray> lines = cmd->m_cmdString.toLocal8Bit().split('\n');
+    QByteArray text;
+    for (int i = 0; i < lines.size(); i++) {
+	if (!lines[i].isEmpty())
+	    text += token + lines[i] + '\n';
+    }
+    return text;
+}
+
+bool GdbMIDriver::canPipeline(const CmdQueueItem* cmd) const
+{
+    // only commands that do not change gdb's state
+    switch (cmd->m_cmd) {
+    case DCinfolocals:
+    case DCframelocals:
+    case DCbtall:
+    case DCinforegisters:
+    case DCregistervalues:
+    case DCexamine:
+    case DCinfoline:
+    case DCdisassemble:
+    case DCbt:
+    case DCbtrange:
+    case DCprint:
+    case DCprintDeref:
+    case DCprintStruct:
+    case DCprintStructBatch:
+    case DCprintPage:
+    case DCprintQStringStruct:
+    case DCprintPopup:
+    case DCprintWChar:
+    case DCfindType:
+    case DCinfosharedlib:
+    case DCinfothreads:
+    case DCinfobreak:
+	return true;
+    default:
+	return false;
+    }
+}
+
+void GdbMIDriver::commandFinished(CmdQueueItem* cmd)
+{
+    // command string must be committed
+    if (!cmd->m_committed) {
+	// not commited!
+	TRACE("calling " + (__PRETTY_FUNCTION__ + (" with uncommited command:\n\t" +
+	      cmd->m_cmdString)));
+	return;
+    }
+
+    /*
+     * Split the response into what the CLI would have printed (console
+     * stream and error messages) and the records that the MI parsers
+     * look at. Other records, the output of the program, and the
+     * echo of CLI commands are dropped.
+     */
+    QByteArray console, records;
+    const char* p = m_output.constData();
+    while (*p != '\0') {
+	const char* end = strchr(p, '\n');
+	if (end == 0)
+	    end = p + strlen(p);
+	const char* r = p;
+	while (isdigit(*r))		/* skip the token */
+	    r++;
+	if (*r == '~' && r[1] == '"') {
+	    r++;
+	    parseCString(r, console);
+	} else if (*r == '^' || strncmp(r, "*stopped", 8) == 0) {
+	    if (strncmp(r, "^error,", 7) == 0) {
+		MIValue* error = parseMIRecord(r+6);
+		console += error->str("msg").toLatin1() + '\n';
+		delete error;
+	    }
+	    // keep the outputs of the lines of a batch apart; the
+	    // results of -break-insert are needed to parse them
+	    if (*r == '^' && cmd->m_cmd == DCbreakbatch)
+		console += QByteArray(r, end-r) + '\n';
+	    if (*r == '^' && (cmd->m_cmd == DCprintStructBatch || cmd->m_cmd == DCbreakbatch))
+		console += BATCH_SEPARATOR;
+	    records += QByteArray(r, end-r) + '\n';
+	}
+	p = *end == '\n' ? end+1 : end;
+    }
+
+    if (cmd->m_cmd == DCinitialize) {
+	parseGdbVersion(console);
+    }
+
+    m_output = console;
+    if (cmd->m_cmdString.startsWith('-'))
+	m_output += records;
+
+    /* ok, the command is ready */
+    emit commandReceived(cmd, m_output.constData());
+
+    switch (cmd->m_cmd) {
+    case DCcorefile:
+    case DCinfolinemain:
+    case DCinfoline:
+    case DCframe:
+    case DCattach:
+    case DCrun:
+    case DCcont:
+    case DCstep:
+    case DCstepi:
+    case DCnext:
+    case DCnexti:
+    case DCfinish:
+    case DCuntil:
+	if (!activateFrame(cmd, records))
+	    parseMarker(cmd);
+    default:;
+    }
+}
+
+/*
+ * gdb reports what a logpoint printed in the console stream. It also
+ * announces the new hit count of the logpoint each time; we drop these
+ * notifications, too.
+ */
+bool GdbMIDriver::logpointLine(const char* line, int len, QStringList& lines)
+{
+    if (len >= 20 && strncmp(line, "=breakpoint-modified", 20) == 0)
+	return true;
+    static const int tagLen = strlen(logpointTag);
+    if (len < tagLen+2 || line[0] != '~' || line[1] != '"' ||
+	strncmp(line+2, logpointTag, tagLen) != 0)
+	return false;
+
+    QByteArray text;
+    const char* p = line+1;
+    parseCString(p, text);
+    if (text.endsWith('\n'))
+	text.chop(1);
+    lines.append(QString::fromLocal8Bit(text.constData()+tagLen, text.length()-tagLen));
+    return true;
+}
+
+std::list<QByteArray> GdbMIDriver::parseBatchOutput(const char* output)
+{
+    // commandFinished has terminated the output of each line
+    std::list<QByteArray> parts = QByteArray(output).split(BATCH_SEPARATOR).toStdList();
+    parts.pop_back();
+    return parts;
+}
+
+bool GdbMIDriver::activateFrame(CmdQueueItem* cmd, const QByteArray& records)
+{
+    MIValue* record = 0;
+    const MIValue* frame = 0;
+    const char* stopped = findMIRecord(records.constData(), "*stopped");
+    if (stopped != 0) {
+	record = parseMIRecord(stopped);
+	frame = record->find("frame");
+    } else if (cmd->m_cmd == DCinfolinemain) {
+	// -file-list-exec-source-file reports the position in the record
+	record = parseDoneRecord(records.constData(), "fullname");
+	frame = record;
+    } else {
+	record = parseDoneRecord(records.constData(), "frame");
+	if (record != 0)
+	    frame = record->find("frame");
+    }
+
+    bool found = false;
+    if (frame != 0) {
+	QString file = frame->str("fullname");
+	int lineNo = frame->num("line", 0);
+	if (!file.isEmpty() && lineNo > 0) {
+	    // get address unless there is one in cmd
+	    DbgAddr address = cmd->m_addr;
+	    if (address.isEmpty())
+		address = frame->str("addr");
+	    emit activateFileLine(file, lineNo-1, address);
+	    found = true;
+	}
+    }
+    delete record;
+    return found;
+}
+
+bool GdbMIDriver::parseBackTrace(const char* output, std::list<StackFrame>& stack)
+{
+    MIValue* record = parseDoneRecord(output, "stack");
+    if (record == 0)
+	return false;
+
+    QString func;
+    for (const MIValue* f = record->find("stack")->m_child; f != 0; f = f->m_next)
+    {
+	stack.push_back(StackFrame());
+	StackFrame* frm = &stack.back();
+	frm->frameNo = f->num("level", 0);
+	parseMIFrame(f, func, frm->fileName, frm->lineNo, frm->address);
+	frm->var = new ExprValue(func, VarTree::NKplain);
+    }
+    delete record;
+    /*
+     * There is no marker for deeper stacks; the caller requests one frame
+     * more than it shows and compares the count.
+     */
+    return false;
+}
+
+bool GdbMIDriver::parseFrameChange(const char* output, int& frameNo,
+				   QString& file, int& lineNo, DbgAddr& address)
+{
+    MIValue* record = parseDoneRecord(output, "frame");
+    if (record == 0)
+	return false;
+
+    const MIValue* frame = record->find("frame");
+    QString func;
+    frameNo = frame->num("level", 0);
+    parseMIFrame(frame, func, file, lineNo, address);
+    delete record;
+    return true;
+}
+
+bool GdbMIDriver::parseBreakList(const char* output, std::list<Breakpoint>& brks)
+{
+    MIValue* record = parseDoneRecord(output, "BreakpointTable");
+    if (record == 0)
+	return false;
+
+    const MIValue* body = record->find("BreakpointTable")->find("body");
+    for (const MIValue* b = body ? body->m_child : 0; b != 0; b = b->m_next)
+    {
+	Breakpoint bp;
+	QByteArray number = b->find("number") ? b->find("number")->m_value : QByteArray();
+	bp.id = atoi(number.constData());
+
+	// recent gdbs list the locations of a <MULTIPLE> breakpoint inside
+	const MIValue* loc = b;
+	const MIValue* locations = b->find("locations");
+	if (locations != 0 && locations->m_child != 0)
+	    loc = locations->m_child;
+
+	QString addr = loc->str("addr");
+	if (addr.startsWith("0x"))
+	    bp.address = addr;
+
+	// location as the CLI prints it
+	QString func = loc->str("func");
+	QString file = loc->str("file");
+	if (!file.isEmpty()) {
+	    bp.location = func.isEmpty() ? QString() : "in " + func + " ";
+	    bp.location += "at " + file + ":" + loc->str("line");
+	    bp.fileName = loc->str("fullname");
+	    if (bp.fileName.isEmpty())
+		bp.fileName = file;
+	    bp.lineNo = loc->num("line", 0) - 1;
+	} else if (!b->str("what").isEmpty()) {
+	    bp.location = b->str("what");
+	} else if (!b->str("exp").isEmpty()) {
+	    bp.location = b->str("exp");
+	} else if (addr != "<MULTIPLE>") {
+	    bp.location = b->str("original-location");
+	}
+
+	// older gdbs list them separately, numbered "id.n"
+	if (number.contains('.')) {
+	    if (!brks.empty() && brks.back().id == bp.id) {
+		Breakpoint& mbp = brks.back();
+		if (mbp.location.isEmpty() && !bp.location.isEmpty()) {
+		    mbp.location = bp.location;
+		    mbp.fileName = bp.fileName;
+		    mbp.lineNo = bp.lineNo;
+		    mbp.address = bp.address;
+		} else if (mbp.address.isEmpty() && !bp.address.isEmpty()) {
+		    mbp.address = bp.address;
+		}
+	    }
+	    continue;
+	}
+
+	if (b->str("type").contains("watchpoint"))
+	    bp.type = Breakpoint::watchpoint;
+	else if (b->str("type") == "dprintf")
+	    bp.type = Breakpoint::logpoint;
+	bp.temporary = b->str("disp") == "del";
+	bp.enabled = b->str("enabled") == "y";
+	bp.condition = b->str("cond");
+	bp.condTarget = b->str("evaluated-by") == "target";
+	bp.ignoreCount = b->num("ignore", 0);
+	bp.hitCount = b->num("times", 0);
+	brks.push_back(bp);
+    }
+    delete record;
+    return true;
+}
+
+std::list<ThreadInfo> GdbMIDriver::parseThreadList(const char* output)
+{
+    std::list<ThreadInfo> threads;
+    MIValue* record = parseDoneRecord(output, "threads");
+    if (record == 0)
+	return threads;
+
+    QString current = record->str("current-thread-id");
+    for (const MIValue* t = record->find("threads")->m_child; t != 0; t = t->m_next)
+    {
+	ThreadInfo thr;
+	thr.id = t->num("id", 0);
+	thr.hasFocus = t->str("id") == current;
+	thr.threadName = t->str("target-id");
+	QString name = t->str("name");
+	if (!name.isEmpty())
+	    thr.threadName += " \"" + name + "\"";
+
+	const MIValue* frame = t->find("frame");
+	if (frame != 0) {
+	    parseMIFrame(frame, thr.function, thr.fileName, thr.lineNo, thr.address);
+	} else {
+	    thr.function = t->str("state") == "running" ? "(running)" : "[No stack]";
+	    thr.lineNo = -1;
+	}
+	threads.push_back(thr);
+    }
+    delete record;
+    return threads;
+}
+
+bool GdbMIDriver::parseBreakpoint(const char* output, int& id,
+				  QString& file, int& lineNo, QString& address)
+{
+    MIValue* record = parseDoneRecord(output, "bkpt");
+    if (record == 0) {
+	// DCbreaktext and DCwatchpoint go through the CLI
+	return GdbDriver::parseBreakpoint(output, id, file, lineNo, address);
+    }
+
+    const MIValue* bkpt = record->find("bkpt");
+    id = bkpt->num("number", -1);
+    QString addr = bkpt->str("addr");
+    if (addr.startsWith("0x"))
+	address = addr;
+    int line = bkpt->num("line", 0);
+    if (line > 0) {
+	file = bkpt->str("fullname");
+	if (file.isEmpty())
+	    file = bkpt->str("file");
+	lineNo = line-1;		/* zero-based! */
+    }
+    delete record;
+    return id >= 0;
+}
+
+void GdbMIDriver::parseLocals(const char* output, std::list<ExprValue*>& newVars)
+{
+    MIValue* record = parseDoneRecord(output, "variables");
+    if (record == 0)
+	return;
+
+    /*
+     * gdb lists arguments and locals in no particular order. Local
+     * variables supersede arguments with the same name, therefore,
+     * arguments must come last.
+     */
+    std::list<ExprValue*> args;
+    for (const MIValue* v = record->find("variables")->m_child; v != 0; v = v->m_next)
+    {
+	QString name = v->str("name");
+	const MIValue* val = v->find("value");
+	if (name.isEmpty() || val == 0)
+	    continue;
+	ExprValue* variable = parseValueString(name, val->m_value.constData());
+	if (variable == 0) {
+	    // show what we could not parse
+	    variable = new ExprValue(name, VarTree::NKplain);
+	    variable->m_value = QString::fromLatin1(val->m_value);
+	}
+	if (v->find("arg") != 0)
+	    args.push_back(variable);
+	else
+	    newVars.push_back(variable);
+    }
+    delete record;
+
+    newVars.splice(newVars.end(), args);
+
+    // do not add duplicates; the first one with a name wins
+    QSet<QString> names;
+    std::list<ExprValue*>::iterator i = newVars.begin();
+    while (i != newVars.end()) {
+	if (names.contains((*i)->m_name)) {
+	    delete *i;
+	    i = newVars.erase(i);
+	} else {
+	    names.insert((*i)->m_name);
+	    ++i;
+	}
+    }
+}
+
+uint GdbMIDriver::parseProgramStopped(const char* output, QString& message)
+{
+    const char* stopped = findMIRecord(output, "*stopped");
+    if (stopped == 0) {
+	// the command failed or switched threads; look at the console
+	return GdbDriver::parseProgramStopped(output, message);
+    }
+
+    MIValue* record = parseMIRecord(stopped);
+    QString reason = record->str("reason");
+    uint flags = SFprogramActive;
+    message = QString();
+
+    if (reason == "breakpoint-hit") {
+	flags |= SFrefreshBreak;
+    } else if (reason == "signal-received") {
+	message = "Program received signal " + record->str("signal-name") +
+		  ", " + record->str("signal-meaning") + ".";
+    } else if (reason == "exited-normally") {
+	flags &= ~SFprogramActive;
+	message = "Program exited normally.";
+    } else if (reason == "exited") {
+	flags &= ~SFprogramActive;
+	message = "Program exited with code " + record->str("exit-code") + ".";
+    } else if (reason == "exited-signalled") {
+	flags &= ~SFprogramActive;
+	message = "Program terminated with signal " + record->str("signal-name") +
+		  ", " + record->str("signal-meaning") + ".";
+    }
+    delete record;
+
+    if (strstr(output, "re-reading symbols.") != 0)
+	flags |= SFrefreshSource;
+
+    /*
+     * Gdb only notices when new threads have appeared, but not when a
+     * thread finishes. So we always have to assume that the list of
+     * threads has changed.
+     */
+    flags |= SFrefreshThreads;
+
+    return flags;
+}
+
+std::list<RegisterInfo> GdbMIDriver::parseRegisters(const char* output)
+{
+    if (findMIRecord(output, "^done") == 0 && findMIRecord(output, "^error") == 0) {
+	// there are no records: DCregistervalues is run by the CLI
+	return GdbDriver::parseRegisters(output);
+    }
+
+    std::list<RegisterInfo> regs;
+    MIValue* names = parseDoneRecord(output, "register-names");
+    MIValue* raw = parseDoneRecord(output, "register-values", 0);
+    MIValue* natural = parseDoneRecord(output, "register-values", 1);
+
+    if (names != 0 && raw != 0)
+    {
+	// the names are indexed by the register number
+	std::vector<QString> regNames;
+	for (const MIValue* n = names->find("register-names")->m_child; n != 0; n = n->m_next)
+	    regNames.push_back(QString::fromLatin1(n->m_value));
+
+	std::map<int,QString> cooked;
+	if (natural != 0) {
+	    for (const MIValue* v = natural->find("register-values")->m_child; v != 0; v = v->m_next)
+		cooked[v->num("number", -1)] = v->str("value");
+	}
+
+	for (const MIValue* v = raw->find("register-values")->m_child; v != 0; v = v->m_next)
+	{
+	    int n = v->num("number", -1);
+	    if (n < 0 || n >= int(regNames.size()) || regNames[n].isEmpty())
+		continue;
+	    RegisterInfo reg;
+	    reg.regName = regNames[n];
+	    reg.rawValue = v->str("value");
+	    QString value = cooked[n];
+	    // get rid of the braces of vector registers
+	    if (value.startsWith("{") && value.endsWith("}"))
+		value = value.mid(1, value.length()-2);
+	    if (reg.rawValue.startsWith("{") && reg.rawValue.endsWith("}"))
+		reg.rawValue = reg.rawValue.mid(1, reg.rawValue.length()-2);
+	    if (value != reg.rawValue)
+		reg.cookedValue = value;
+	    regs.push_back(reg);
+	}
+    }
+    delete names;
+    delete raw;
+    delete natural;
+    return regs;
+}
+
+#include "gdbmidriver.moc"
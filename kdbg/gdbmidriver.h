@@ -0,0 +1,67 @@
+/*
+ * Copyright Johannes Sixt
+ * This file is licensed under the GNU General Public License Version 2.
+ * See the file COPYING in the toplevel directory of the source directory.
+ */
+
+#ifndef GDBMIDRIVER_H
+#define GDBMIDRIVER_H
+
+#include "gdbdriver.h"
+
+
+/**
+ * This driver talks to gdb using the machine interface (MI) instead of
+ * scraping the output of CLI commands.
+ *
+ * Backtraces, breakpoints, threads, registers, locals, and the positions
+ * where the program stops are requested with MI commands, and their
+ * result records are decoded in a single pass. All other commands are
+ * passed to gdb's CLI interpreter; their console output is fed to the
+ * parsers inherited from GdbDriver.
+ */
+class GdbMIDriver : public GdbDriver
+{
+    Q_OBJECT
+public:
+    GdbMIDriver();
+    ~GdbMIDriver();
+
+    virtual QString driverName() const;
+    virtual QString defaultInvocation() const;
+    virtual bool canListFrameLocals() const { return true; }
+    virtual bool canListFrameRange() const { return true; }
+    static QString defaultGdbMI();
+    virtual bool startup(QString cmdStr);
+    virtual void commandFinished(CmdQueueItem* cmd);
+
+    virtual bool parseBackTrace(const char* output, std::list<StackFrame>& stack);
+    virtual bool parseFrameChange(const char* output, int& frameNo,
+				  QString& file, int& lineNo, DbgAddr& address);
+    virtual bool parseBreakList(const char* output, std::list<Breakpoint>& brks);
+    virtual std::list<ThreadInfo> parseThreadList(const char* output);
+    virtual bool parseBreakpoint(const char* output, int& id,
+				 QString& file, int& lineNo, QString& address);
+    virtual void parseLocals(const char* output, std::list<ExprValue*>& newVars);
+    virtual uint parseProgramStopped(const char* output, QString& message);
+    virtual std::list<RegisterInfo> parseRegisters(const char* output);
+    virtual std::list<QByteArray> parseBatchOutput(const char* output);
+protected:
+    virtual const char* initCommands() const;
+    virtual const char* cmdFormat(DbgCommand cmd) const;
+    virtual int findPrompt(const QByteArray& output, int& scanned, int& promptEnd);
+    virtual QByteArray commandText(const CmdQueueItem* cmd) const;
+    virtual bool canPipeline(const CmdQueueItem* cmd) const;
+    virtual bool logpointLine(const char* line, int len, QStringList& lines);
+    /**
+     * Shows the source position that is reported in the frame of a
+     * *stopped record or a result record.
+     * @return false if the records do not report a source position.
+     */
+    bool activateFrame(CmdQueueItem* cmd, const QByteArray& records);
+
+    int m_scanResults;			/* result records seen by findPrompt() */
+    bool m_scanRunning;			/* whether the program runs meanwhile */
+};
+
+#endif // GDBMIDRIVER_H
@@ -0,0 +1,65 @@
+/*
+ * Copyright Johannes Sixt
+ * This file is licensed under the GNU General Public License Version 2.
+ * See the file COPYING in the toplevel directory of the source directory.
+ */
+
+#include "logpointwnd.h"
+#include <QContextMenuEvent>
+#include <QMenu>
+#include <QScrollBar>
+#include <QStringList>
+#include <kglobalsettings.h>
+#include <klocale.h>
+
+// the number of lines that are kept
+static const int MaxLines = 10000;
+
+
+LogpointWindow::LogpointWindow(QWidget* parent) :
+	QPlainTextEdit(parent)
+{
+    setFont(KGlobalSettings::fixedFont());
+    setReadOnly(true);
+    setWordWrapMode(QTextOption::NoWrap);
+    setUndoRedoEnabled(false);
+    setMaximumBlockCount(MaxLines);
+}
+
+LogpointWindow::~LogpointWindow()
+{
+}
+
+/*
+ * The lines arrive in chunks as gdb prints them; each chunk is added in
+ * one go. If the view was scrolled back, it is not moved to the end.
+ */
+void LogpointWindow::appendLines(const QStringList& lines)
+{
+    QScrollBar* sb = verticalScrollBar();
+    bool atEnd = sb->value() == sb->maximum();
+
+    // don't bother to lay out lines that are discarded right away
+    int skip = qMax(lines.size() - MaxLines, 0);
+    QStringList shown = skip > 0 ? lines.mid(skip) : lines;
+
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    if (!document()->isEmpty())
+	cursor.insertText(QString('\n'));
+    cursor.insertText(shown.join("\n"));
+
+    if (atEnd)
+	sb->setValue(sb->maximum());
+}
+
+void LogpointWindow::contextMenuEvent(QContextMenuEvent* event)
+{
+    QMenu* menu = createStandardContextMenu();
+    menu->addSeparator();
+    menu->addAction(i18n("&Clear"), this, SLOT(clear()));
+    menu->exec(event->globalPos());
+    delete menu;
+}
+
+#include "logpointwnd.moc"
@@ -0,0 +1,32 @@
+/*
+ * Copyright Johannes Sixt
+ * This file is licensed under the GNU General Public License Version 2.
+ * See the file COPYING in the toplevel directory of the source directory.
+ */
+
+#ifndef LOGPOINTWND_H
+#define LOGPOINTWND_H
+
+#include <QPlainTextEdit>
+
+class QStringList;
+
+/**
+ * Shows what the logpoints printed. Only the most recent lines are
+ * kept, so that logpoints that are hit very often do not eat up memory.
+ */
+class LogpointWindow : public QPlainTextEdit
+{
+    Q_OBJECT
+public:
+    LogpointWindow(QWidget* parent);
+    ~LogpointWindow();
+
+protected:
+    virtual void contextMenuEvent(QContextMenuEvent*);
+
+public slots:
+    void appendLines(const QStringList& lines);
+};
+
+#endif // LOGPOINTWND_H
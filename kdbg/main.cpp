@@ -43,7 +43,8 @@ int main(int argc, char** argv)
     KCmdLineOptions opts;
     opts.add("t <file>", ki18n("transcript of conversation with the debugger"));
     opts.add("r <device>", ki18n("remote debugging via <device>"));
-    opts.add("l <language>", ki18n("specify language: C, XSLT"));
+    opts.add("gdbserver", ki18n("run the program under a local gdbserver"));
+    opts.add("l <language>", ki18n("specify language: C, XSLT, GDBMI"));
     opts.add("x", ki18n("use language XSLT (deprecated)"));
     opts.add("a <args>", ki18n("specify arguments of debugged executable"));
     opts.add("p <pid>", ki18n("specify PID of process to debug"));
@@ -80,6 +81,8 @@ int main(int argc, char** argv)
     QString remote = args->getOption("r");
     if (!remote.isEmpty())
 	debugger->setRemoteDevice(remote);
+    if (args->isSet("gdbserver"))
+	debugger->setRunGdbserver(true);
 
     QString lang = args->getOption("l");
 
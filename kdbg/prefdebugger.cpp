@@ -15,7 +15,11 @@ PrefDebugger::PrefDebugger(QWidget* parent) :
 	m_debuggerCCpp(this),
 	m_terminalHint(this),
 	m_terminalLabel(this),
-	m_terminal(this)
+	m_terminal(this),
+	m_pipelineDepthLabel(this),
+	m_pipelineDepth(this),
+	m_arrayPageSizeLabel(this),
+	m_arrayPageSize(this)
 {
     m_defaultHint.setText(i18n("To revert to the default settings, clear the entries."));
     m_defaultHint.setMinimumHeight(m_defaultHint.sizeHint().height());
@@ -41,7 +45,21 @@ PrefDebugger::PrefDebugger(QWidget* parent) :
     m_grid.addWidget(&m_terminalLabel, 3, 0);
     m_grid.addWidget(&m_terminal, 3, 1);
 
+    m_pipelineDepthLabel.setText(i18n("&Commands in flight (GDB/MI only):"));
+    m_pipelineDepthLabel.setMinimumSize(m_pipelineDepthLabel.sizeHint());
+    m_pipelineDepthLabel.setBuddy(&m_pipelineDepth);
+    m_pipelineDepth.setMinimumSize(m_pipelineDepth.sizeHint());
+    m_grid.addWidget(&m_pipelineDepthLabel, 4, 0);
+    m_grid.addWidget(&m_pipelineDepth, 4, 1);
+
+    m_arrayPageSizeLabel.setText(i18n("&Array elements shown at once (0 = all):"));
+    m_arrayPageSizeLabel.setMinimumSize(m_arrayPageSizeLabel.sizeHint());
+    m_arrayPageSizeLabel.setBuddy(&m_arrayPageSize);
+    m_arrayPageSize.setMinimumSize(m_arrayPageSize.sizeHint());
+    m_grid.addWidget(&m_arrayPageSizeLabel, 5, 0);
+    m_grid.addWidget(&m_arrayPageSize, 5, 1);
+
     m_grid.setColumnStretch(1, 10);
     // last (empty) row gets all the vertical stretch
-    m_grid.setRowStretch(4, 10);
+    m_grid.setRowStretch(6, 10);
 }
@@ -38,6 +38,22 @@ protected:
 public:
     QString terminal() const { return m_terminal.text(); }
     void setTerminal(const QString& t) { m_terminal.setText(t); }
+
+    // --- the number of commands sent ahead
+protected:
+    QLabel m_pipelineDepthLabel;
+    QLineEdit m_pipelineDepth;
+public:
+    int pipelineDepth() const { return m_pipelineDepth.text().toInt(); }
+    void setPipelineDepth(int depth) { m_pipelineDepth.setText(QString::number(depth)); }
+
+    // --- the number of array elements that are printed at once
+protected:
+    QLabel m_arrayPageSizeLabel;
+    QLineEdit m_arrayPageSize;
+public:
+    int arrayPageSize() const { return m_arrayPageSize.text().toInt(); }
+    void setArrayPageSize(int n) { m_arrayPageSize.setText(QString::number(n)); }
 };
 
 #endif // PREFDEBUGGER_H
@@ -18,7 +18,8 @@ PrefMisc::PrefMisc(QWidget* parent) :
 	m_sourceFilterLabel(this),
 	m_sourceFilter(this),
 	m_headerFilterLabel(this),
-	m_headerFilter(this)
+	m_headerFilter(this),
+	m_lightweightLocals(this)
 {
     m_popForeground.setText(i18n("&Pop into foreground when program stops"));
     m_popForeground.setMinimumSize(m_popForeground.sizeHint());
@@ -39,9 +40,13 @@ PrefMisc::PrefMisc(QWidget* parent) :
     setupEditGroup(i18n("File filter for &header files:"),
 		   m_headerFilterLabel, m_headerFilter, 4);
 
+    m_lightweightLocals.setText(i18n("Show &locals in a lightweight, read-only view"));
+    m_lightweightLocals.setMinimumSize(m_lightweightLocals.sizeHint());
+    m_grid.addWidget(&m_lightweightLocals, 5, 0, 1, 2);
+
     m_grid.setColumnStretch(1, 10);
     // last (empty) row gets all the vertical stretch
-    m_grid.setRowStretch(5, 10);
+    m_grid.setRowStretch(6, 10);
 }
 
 void PrefMisc::setupEditGroup(const QString& label, QLabel& labWidget, QLineEdit& edit, int row)
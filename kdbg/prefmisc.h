@@ -33,6 +33,8 @@ protected:
     QLabel m_headerFilterLabel;
     QLineEdit m_headerFilter;
 
+    QCheckBox m_lightweightLocals;
+
     void setupEditGroup(const QString& label, QLabel& labWidget, QLineEdit& edit, int row);
 
 public:
@@ -46,6 +48,8 @@ public:
     void setSourceFilter(const QString& f) { m_sourceFilter.setText(f); }
     QString headerFilter() const { return m_headerFilter.text(); }
     void setHeaderFilter(const QString& f) { m_headerFilter.setText(f); }
+    bool lightweightLocals() const { return m_lightweightLocals.isChecked(); }
+    void setLightweightLocals(bool on) { m_lightweightLocals.setChecked(on); }
 };
 
 #endif // PREFMISC_H
@@ -107,10 +107,10 @@ class GroupingViewItem : public ModeItem
 public:
     GroupingViewItem(RegisterView* parent, 
 		     const QString& name, const QString& pattern,
-		     RegisterDisplay mode) :
+		     RegisterDisplay mode, bool expanded = true) :
 	ModeItem(parent, name), matcher(pattern), gmode(mode)
     {
-	setExpanded(true);
+	setExpanded(expanded);
     } 
 
     bool matchName(const QString& str) const
@@ -432,7 +432,16 @@ RegisterView::RegisterView(QWidget* parent) :
 	}
     }
     connect(m_modemenu, SIGNAL(triggered(QAction*)), SLOT(slotModeChange(QAction*)));
-    
+    connect(this, SIGNAL(itemExpanded(QTreeWidgetItem*)),
+	    SLOT(slotGroupToggled(QTreeWidgetItem*)));
+    connect(this, SIGNAL(itemCollapsed(QTreeWidgetItem*)),
+	    SLOT(slotGroupToggled(QTreeWidgetItem*)));
+
+    /*
+     * The floating point and vector registers are numerous and costly to
+     * retrieve; their groups are initially collapsed so that their
+     * values are not requested on every stop.
+     */
     new GroupingViewItem(this, i18n("GP and others"), "^$",
 			 RegisterDisplay::nada);
     new GroupingViewItem(this, i18n("Flags"),
@@ -442,17 +451,21 @@ RegisterView::RegisterView(QWidget* parent) :
 			 "(^cs$|^ss$|^ds$|^es$|^fs$|^gs$|^fiseg$|^foseg$)",
 			 RegisterDisplay::nada);
     new GroupingViewItem(this, "x87", "^st.*",
-			 RegisterDisplay::bits80|RegisterDisplay::realE);
+			 RegisterDisplay::bits80|RegisterDisplay::realE, false);
     new GroupingViewItem(this, "SSE", "^xmm.*",
-			 RegisterDisplay::bits32|RegisterDisplay::realE);
+			 RegisterDisplay::bits32|RegisterDisplay::realE, false);
+    new GroupingViewItem(this, "AVX", "^ymm.*",
+			 RegisterDisplay::bits32|RegisterDisplay::realE, false);
+    new GroupingViewItem(this, "AVX-512", "(^zmm.*|^k[0-7]$)",
+			 RegisterDisplay::bits32|RegisterDisplay::realE, false);
     new GroupingViewItem(this, "MMX", "^mm.*",
-			 RegisterDisplay::bits32|RegisterDisplay::realE);
+			 RegisterDisplay::bits32|RegisterDisplay::realE, false);
     new GroupingViewItem(this, "POWER real", "^fpr.*",
-			 RegisterDisplay::bits32|RegisterDisplay::realE);
+			 RegisterDisplay::bits32|RegisterDisplay::realE, false);
     new GroupingViewItem(this, "AltiVec", "^vr.*",
-			 RegisterDisplay::bits32|RegisterDisplay::realE);
+			 RegisterDisplay::bits32|RegisterDisplay::realE, false);
     new GroupingViewItem(this, "MIPS VU", "^vu.*",
-			 RegisterDisplay::bits32|RegisterDisplay::realE);
+			 RegisterDisplay::bits32|RegisterDisplay::realE, false);
 
     updateGroupVisibility();
     setRootIsDecorated(true);
@@ -498,6 +511,43 @@ void RegisterView::updateGroupVisibility()
     }
 }
 
+/*
+ * Registers are compared by their raw value first; the decoded value is
+ * compared only if the raw values are equal.
+ */
+bool RegisterView::updateRegister(const RegisterInfo& reg)
+{
+    RegMap::iterator i = m_registers.find(reg.regName);
+    if (i == m_registers.end())
+	return false;
+
+    RegisterViewItem* it = i.value();
+    it->m_found = true;
+    if (it->m_reg.rawValue != reg.rawValue ||
+	it->m_reg.cookedValue != reg.cookedValue)
+    {
+	it->m_changes = true;
+	it->setValue(reg);
+
+	it->setForeground(0,Qt::red);
+	it->setForeground(1,Qt::red);
+	it->setForeground(2,Qt::red);
+
+    } else {
+	/*
+	 * If there was a change last time, but not now, we
+	 * must revert the color.
+	 */
+	if (it->m_changes) {
+	    it->m_changes = false;
+	    it->setForeground(0,Qt::black);
+	    it->setForeground(1,Qt::black);
+	    it->setForeground(2,Qt::black);
+	}
+    }
+    return true;
+}
+
 void RegisterView::updateRegisters(const std::list<RegisterInfo>& regs)
 {
     setUpdatesEnabled(false);
@@ -505,43 +555,14 @@ void RegisterView::updateRegisters(const std::list<RegisterInfo>& regs)
     // mark all items as 'not found'
     for (RegMap::iterator i = m_registers.begin(); i != m_registers.end(); ++i)
     {
-	i->second->m_found = false;
+	i.value()->m_found = false;
     }
 
     // parse register values
     for (std::list<RegisterInfo>::const_iterator reg = regs.begin(); reg != regs.end(); ++reg)
     {
 	// check if this is a new register
-	RegMap::iterator i = m_registers.find(reg->regName);
-
-	if (i != m_registers.end())
-	{
-	    RegisterViewItem* it = i->second;
-	    it->m_found = true;
-	    if (it->m_reg.rawValue != reg->rawValue ||
-		it->m_reg.cookedValue != reg->cookedValue)
-	    {
-		it->m_changes = true;
-		it->setValue(*reg);
-
-		it->setForeground(0,Qt::red);
-		it->setForeground(1,Qt::red);
-		it->setForeground(2,Qt::red);
-
-	    } else {
-		/*
-		 * If there was a change last time, but not now, we
-		 * must revert the color.
-		 */
-		if (it->m_changes) {
-		    it->m_changes = false;
-		    it->setForeground(0,Qt::black);
-		    it->setForeground(1,Qt::black);
-		    it->setForeground(2,Qt::black);
-		}
-	    }
-	}
-	else
+	if (!updateRegister(*reg))
 	{
 	    GroupingViewItem* group = findMatchingGroup(reg->regName);
 	    m_registers[reg->regName] =
@@ -550,24 +571,54 @@ void RegisterView::updateRegisters(const std::list<RegisterInfo>& regs)
     }
 
     // remove all 'not found' items;
-    QStringList del;
-    for (RegMap::iterator i = m_registers.begin(); i != m_registers.end(); ++i)
+    for (RegMap::iterator i = m_registers.begin(); i != m_registers.end(); )
     {
-	if (!i->second->m_found) {
-	    del.push_back(i->first);
+	if (!i.value()->m_found) {
+	    delete i.value();
+	    i = m_registers.erase(i);
+	} else {
+	    ++i;
 	}
     }
-    for (QStringList::Iterator i = del.begin(); i != del.end(); ++i)
+
+    updateGroupVisibility();
+    setUpdatesEnabled(true);
+
+    emit wantedRegistersChanged(wantedRegisters());
+}
+
+void RegisterView::updateRegisterValues(const std::list<RegisterInfo>& regs)
+{
+    setUpdatesEnabled(false);
+
+    // registers that are not listed keep their values
+    for (std::list<RegisterInfo>::const_iterator reg = regs.begin(); reg != regs.end(); ++reg)
     {
-	RegMap::iterator it = m_registers.find(*i);
-	delete it->second;
-	m_registers.erase(it);
+	updateRegister(*reg);
     }
 
-    updateGroupVisibility();
     setUpdatesEnabled(true);
 }
-  
+
+QStringList RegisterView::wantedRegisters() const
+{
+    QStringList names;
+    for (int i = 0; i < topLevelItemCount(); i++)
+    {
+	QTreeWidgetItem* group = topLevelItem(i);
+	if (!group->isExpanded())
+	    continue;
+	for (int j = 0; j < group->childCount(); j++)
+	    names.append(group->child(j)->text(0));
+    }
+    return names;
+}
+
+void RegisterView::slotGroupToggled(QTreeWidgetItem* item)
+{
+    if (item->parent() == 0)
+	emit wantedRegistersChanged(wantedRegisters());
+}
 
 void RegisterView::contextMenuEvent(QContextMenuEvent* event)
 {
@@ -593,7 +644,7 @@ void RegisterView::slotModeChange(QAction* action)
     RegMap::iterator it=m_registers.find(m_modemenu->title());
     ModeItem* view;
     if (it != m_registers.end())
-	view = it->second;
+	view = it.value();
     else
 	view = findGroup(m_modemenu->title());
 
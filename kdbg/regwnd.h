@@ -7,9 +7,10 @@
 #ifndef REGWND_H
 #define REGWND_H
 #include <QTreeWidget>
+#include <QHash>
+#include <QStringList>
 
 #include <list>
-#include <map>
 
 class QMenu;
 class RegisterViewItem;
@@ -28,17 +29,35 @@ public:
 protected:
     void contextMenuEvent(QContextMenuEvent*);
 
+    /**
+     * The registers in the groups that are expanded; only their values
+     * need to be updated when the program stops.
+     */
+    QStringList wantedRegisters() const;
+
 protected slots:
     void slotModeChange(QAction*);
+    void slotGroupToggled(QTreeWidgetItem*);
+    /**
+     * Shows the complete list of registers.
+     */
     void updateRegisters(const std::list<RegisterInfo>&);
+    /**
+     * Updates the values of some of the registers.
+     */
+    void updateRegisterValues(const std::list<RegisterInfo>&);
+
+signals:
+    void wantedRegistersChanged(const QStringList& names);
 
 private:
+    bool updateRegister(const RegisterInfo& reg);
     void paletteChange(const QPalette& oldPal);
     void updateGroupVisibility();
     GroupingViewItem* findMatchingGroup(const QString& regName);
     GroupingViewItem* findGroup(const QString& groupName);
     QMenu* m_modemenu;
-    typedef std::map<QString,RegisterViewItem*> RegMap;
+    typedef QHash<QString,RegisterViewItem*> RegMap;
     RegMap m_registers;
 
 friend class RegisterViewItem;
@@ -20,6 +20,7 @@
 #include <kxmlguiwindow.h>
 #include <kxmlguifactory.h>
 #include <algorithm>
+#include <math.h>
 #include "mydebug.h"
 
 
@@ -152,6 +153,16 @@ void SourceWindow::resizeEvent(QResizeEvent* e)
     m_lineInfoArea->setGeometry(cr);
 }
 
+/*
+ * The hit rate of a breakpoint is shown on a logarithmic scale, from pale
+ * yellow for one hit per second to red for 10000 hits per second and more.
+ */
+static QColor heatColor(double rate)
+{
+    double heat = qBound(0.0, log10(1.0+rate)/4.0, 1.0);
+    return QColor::fromHsvF((1.0-heat)/6.0, 0.3+0.7*heat, 1.0);
+}
+
 void SourceWindow::drawLineInfoArea(QPainter* p, QPaintEvent* event)
 {
     QTextBlock block = firstVisibleBlock();
@@ -176,6 +187,12 @@ void SourceWindow::drawLineInfoArea(QPainter* p, QPaintEvent* event)
 	p->save();
 	p->translate(0, r.top());
 
+	if ((item & liBPany) && !isRowDisassCode(row)) {
+	    // how often the breakpoint is hit
+	    double rate = m_lineHeat.value(rowToLine(row));
+	    if (rate > 0)
+		p->fillRect(0, 0, m_widthItems, h, heatColor(rate));
+	}
 	if (item & liBP) {
 	    // enabled breakpoint
 	    int y = (h - m_brkena.height())/2;
@@ -239,54 +256,85 @@ void SourceWindow::drawLineInfoArea(QPainter* p, QPaintEvent* event)
 
 void SourceWindow::updateLineItems(const KDebugger* dbg)
 {
-    // clear outdated breakpoints
+    // clear all breakpoints, then mark those that exist
     for (int i = m_lineItems.size()-1; i >= 0; i--) {
-	if (m_lineItems[i] & liBPany) {
-	    // check if this breakpoint still exists
-	    int line = rowToLine(i);
-	    TRACE(QString().sprintf("checking for bp at %d", line));
-	    KDebugger::BrkptROIterator bp = dbg->breakpointsBegin();
-	    for (; bp != dbg->breakpointsEnd(); ++bp)
-	    {
-		if (bp->lineNo == line &&
-		    fileNameMatches(bp->fileName) &&
-		    lineToRow(line, bp->address) == i)
-		{
-		    // yes it exists; mode is changed below
-		    break;
-		}
-	    }
-	    if (bp == dbg->breakpointsEnd()) {
-		/* doesn't exist anymore, remove it */
-		m_lineItems[i] &= ~liBPany;
-	    }
-	}
+	m_lineItems[i] &= ~liBPany;
+    }
+    m_lineHeat.clear();
+    for (KDebugger::BrkptROIterator bp = dbg->breakpointsBegin(); bp != dbg->breakpointsEnd(); ++bp)
+    {
+	markBreakpoint(*bp);
+    }
+    m_lineInfoArea->update();
+}
+
+/*
+ * Returns the row of the breakpoint or -1 if it is not in this file.
+ */
+int SourceWindow::breakpointRow(const Breakpoint& bp)
+{
+    if (bp.lineNo < 0 || bp.lineNo >= int(m_sourceCode.size()) ||
+	!fileNameMatches(bp.fileName))
+    {
+	return -1;
     }
+    return lineToRow(bp.lineNo, bp.address);
+}
+
+void SourceWindow::markBreakpoint(const Breakpoint& bp)
+{
+    int row = breakpointRow(bp);
+    if (row < 0)
+	return;
+    TRACE(QString("updating %2:%1").arg(bp.lineNo).arg(bp.fileName));
+    // compute new line item flags for breakpoint
+    uchar flags = bp.enabled ? liBP : liBPdisabled;
+    if (bp.temporary)
+	flags |= liBPtemporary;
+    if (!bp.condition.isEmpty() || bp.ignoreCount != 0)
+	flags |= liBPconditional;
+    if (bp.isOrphaned())
+	flags |= liBPorphan;
+    m_lineItems[row] &= ~liBPany;
+    m_lineItems[row] |= flags;
+    if (bp.hitRate > 0)
+	m_lineHeat[bp.lineNo] = bp.hitRate;
+    else
+	m_lineHeat.remove(bp.lineNo);
+}
 
-    // add new breakpoints
+void SourceWindow::updateBreakpoint(const Breakpoint& bp)
+{
+    if (breakpointRow(bp) < 0)
+	return;
+    markBreakpoint(bp);
+    m_lineInfoArea->update();
+}
+
+void SourceWindow::updateBreakpointRates(const KDebugger* dbg)
+{
+    QHash<int,double> heat;
     for (KDebugger::BrkptROIterator bp = dbg->breakpointsBegin(); bp != dbg->breakpointsEnd(); ++bp)
     {
-	if (fileNameMatches(bp->fileName)) {
-	    TRACE(QString("updating %2:%1").arg(bp->lineNo).arg(bp->fileName));
-	    int i = bp->lineNo;
-	    if (i < 0 || i >= int(m_sourceCode.size()))
-		continue;
-	    // compute new line item flags for breakpoint
-	    uchar flags = bp->enabled ? liBP : liBPdisabled;
-	    if (bp->temporary)
-		flags |= liBPtemporary;
-	    if (!bp->condition.isEmpty() || bp->ignoreCount != 0)
-		flags |= liBPconditional;
-	    if (bp->isOrphaned())
-		flags |= liBPorphan;
-	    // update if changed
-	    int row = lineToRow(i, bp->address);
-	    if ((m_lineItems[row] & liBPany) != flags) {
-		m_lineItems[row] &= ~liBPany;
-		m_lineItems[row] |= flags;
-	    }
-	}
+	if (bp->hitRate > 0 && breakpointRow(*bp) >= 0)
+	    heat[bp->lineNo] = bp->hitRate;
+    }
+    if (heat != m_lineHeat) {
+	m_lineHeat = heat;
+	m_lineInfoArea->update();
     }
+}
+
+void SourceWindow::removeBreakpoint(const KDebugger* dbg, const Breakpoint& bp)
+{
+    int row = breakpointRow(bp);
+    if (row < 0)
+	return;
+    m_lineItems[row] &= ~liBPany;
+    m_lineHeat.remove(bp.lineNo);
+    const Breakpoint* other = dbg->breakpointAt(bp.fileName, bp.lineNo, bp.address);
+    if (other != 0)
+	markBreakpoint(*other);
     m_lineInfoArea->update();
 }
 
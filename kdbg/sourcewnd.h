@@ -7,6 +7,7 @@
 #ifndef SOURCEWND_H
 #define SOURCEWND_H
 
+#include <QHash>
 #include <QPixmap>
 #include <QPlainTextEdit>
 #include <QSyntaxHighlighter>
@@ -16,6 +17,7 @@
 // forward declarations
 class KDebugger;
 struct DbgAddr;
+struct Breakpoint;
 class LineInfoArea;
 class HighlightCpp;
 
@@ -32,6 +34,19 @@ public:
     void scrollTo(int lineNo, const DbgAddr& address);
     const QString& fileName() const { return m_fileName; }
     void updateLineItems(const KDebugger* dbg);
+    /**
+     * Shows the marker of a breakpoint that was added or has changed.
+     */
+    void updateBreakpoint(const Breakpoint& bp);
+    /**
+     * Removes the marker of a breakpoint. If another breakpoint remains
+     * at the same place, its marker is shown instead.
+     */
+    void removeBreakpoint(const KDebugger* dbg, const Breakpoint& bp);
+    /**
+     * Shows the current hit rates of the breakpoints in this file.
+     */
+    void updateBreakpointRates(const KDebugger* dbg);
     void setPC(bool set, int lineNo, const DbgAddr& address, int frameNo);
     enum FindDirection { findForward = 1, findBackward = -1 };
     void find(const QString& text, bool caseSensitive, FindDirection dir);
@@ -70,6 +85,8 @@ protected:
     /** translates (0-based) line number plus a code address into a row number */
     int lineToRow(int row, const DbgAddr& address);
     int lineInfoAreaWidth() const;
+    int breakpointRow(const Breakpoint& bp);
+    void markBreakpoint(const Breakpoint& bp);
 
     void actionExpandRow(int row);
     void actionCollapseRow(int row);
@@ -104,6 +121,7 @@ protected:
 
     std::vector<int> m_rowToLine;	//!< The source line number for each row
     std::vector<uchar> m_lineItems;	//!< Icons displayed on the line
+    QHash<int,double> m_lineHeat;	//!< Hit rates of breakpoints by source line
     QPixmap m_pcinner;			/* PC at innermost frame */
     QPixmap m_pcup;			/* PC at frame up the stack */
     QPixmap m_brkena;			/* enabled breakpoint */
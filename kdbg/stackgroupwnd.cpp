@@ -0,0 +1,148 @@
+/*
+ * Copyright Johannes Sixt
+ * This file is licensed under the GNU General Public License Version 2.
+ * See the file COPYING in the toplevel directory of the source directory.
+ */
+
+#include "stackgroupwnd.h"
+#include "dbgdriver.h"
+#include <klocale.h>
+#include <QHash>
+#include <QHeaderView>
+#include <QSet>
+#include <algorithm>
+#include <vector>
+
+// the data roles of the top-level items
+static const int stackKeyRole = Qt::UserRole;
+static const int threadIdRole = Qt::UserRole+1;
+
+
+StackGroupWindow::StackGroupWindow(QWidget* parent) :
+	QTreeWidget(parent)
+{
+    setHeaderLabels(QStringList() << i18n("Threads") << i18n("Location")
+		    << i18n("Thread IDs"));
+    header()->setResizeMode(0, QHeaderView::ResizeToContents);
+    setUniformRowHeights(true);
+
+    connect(this, SIGNAL(itemActivated(QTreeWidgetItem*,int)),
+	    this, SLOT(slotItemActivated(QTreeWidgetItem*)));
+}
+
+StackGroupWindow::~StackGroupWindow()
+{
+}
+
+/*
+ * Frames compare equal if they are in the same function at the same
+ * source line. The arguments are not taken into account because they
+ * differ from thread to thread. Frames without line information compare
+ * by their address.
+ */
+static QString frameKey(const ThreadFrame& frm)
+{
+    QString func = frm.function;
+    int paren = func.indexOf(" (");
+    if (paren >= 0)
+	func.truncate(paren);
+    if (frm.lineNo >= 0)
+	return func + '\t' + frm.fileName + ':' + QString::number(frm.lineNo);
+    return func + '\t' + frm.address.asString();
+}
+
+namespace {
+struct StackGroup {
+    QString key;
+    const ThreadStack* stack;		/* the first thread in this group */
+    QList<int> ids;
+};
+
+bool moreThreads(const StackGroup* a, const StackGroup* b)
+{
+    return a->ids.size() > b->ids.size();
+}
+}
+
+void StackGroupWindow::updateStacks(const std::list<ThreadStack>& stacks)
+{
+    // remember which groups show their frames
+    QSet<QString> expanded;
+    for (int i = 0; i < topLevelItemCount(); i++) {
+	QTreeWidgetItem* item = topLevelItem(i);
+	if (item->isExpanded())
+	    expanded.insert(item->data(0, stackKeyRole).toString());
+    }
+
+    // group the threads by their call stacks
+    QHash<QString,StackGroup*> byKey;
+    std::vector<StackGroup*> groups;
+    for (std::list<ThreadStack>::const_iterator t = stacks.begin(); t != stacks.end(); ++t)
+    {
+	QString key;
+	for (std::list<ThreadFrame>::const_iterator f = t->frames.begin(); f != t->frames.end(); ++f)
+	    key += frameKey(*f) + '\n';
+
+	StackGroup*& g = byKey[key];
+	if (g == 0) {
+	    g = new StackGroup;
+	    g->key = key;
+	    g->stack = &*t;
+	    groups.push_back(g);
+	}
+	g->ids.append(t->id);
+    }
+    std::stable_sort(groups.begin(), groups.end(), moreThreads);
+
+    clear();
+
+    QList<QTreeWidgetItem*> items;
+    for (std::vector<StackGroup*>::iterator it = groups.begin(); it != groups.end(); ++it)
+    {
+	StackGroup* g = *it;
+	QTreeWidgetItem* item = new QTreeWidgetItem;
+	item->setData(0, Qt::DisplayRole, g->ids.size());
+	item->setTextAlignment(0, Qt::AlignRight);
+	item->setData(0, stackKeyRole, g->key);
+	item->setData(0, threadIdRole, g->ids.first());
+	if (g->stack->frames.empty())
+	    item->setText(1, i18n("[No stack]"));
+	else
+	    item->setText(1, g->stack->frames.front().function);
+	QStringList ids;
+	foreach (int id, g->ids)
+	    ids.append(QString::number(id));
+	item->setText(2, ids.join(", "));
+
+	QList<QTreeWidgetItem*> frames;
+	for (std::list<ThreadFrame>::const_iterator f = g->stack->frames.begin();
+	     f != g->stack->frames.end(); ++f)
+	{
+	    QTreeWidgetItem* frm = new QTreeWidgetItem;
+	    frm->setText(0, "#" + QString::number(f->frameNo));
+	    frm->setTextAlignment(0, Qt::AlignRight);
+	    frm->setText(1, f->function);
+	    frames.append(frm);
+	}
+	item->addChildren(frames);
+	items.append(item);
+	delete g;
+    }
+    addTopLevelItems(items);
+
+    // expanding requires that the items are in the tree
+    foreach (QTreeWidgetItem* item, items) {
+	if (expanded.contains(item->data(0, stackKeyRole).toString()))
+	    item->setExpanded(true);
+    }
+}
+
+void StackGroupWindow::slotItemActivated(QTreeWidgetItem* item)
+{
+    // a frame selects the thread of its group
+    if (item->parent() != 0)
+	item = item->parent();
+    emit setThread(item->data(0, threadIdRole).toInt());
+}
+
+#include "stackgroupwnd.moc"
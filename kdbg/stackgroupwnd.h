@@ -0,0 +1,40 @@
+/*
+ * Copyright Johannes Sixt
+ * This file is licensed under the GNU General Public License Version 2.
+ * See the file COPYING in the toplevel directory of the source directory.
+ */
+
+#ifndef STACKGROUPWND_H
+#define STACKGROUPWND_H
+
+#include <QTreeWidget>
+#include <list>
+
+struct ThreadStack;
+
+/**
+ * Shows the backtraces of all threads, where threads whose call stacks
+ * are identical are merged into one entry, so that one can tell at a
+ * glance what a program with many threads is doing.
+ */
+class StackGroupWindow : public QTreeWidget
+{
+    Q_OBJECT
+public:
+    StackGroupWindow(QWidget* parent);
+    ~StackGroupWindow();
+
+public slots:
+    void updateStacks(const std::list<ThreadStack>& stacks);
+
+protected slots:
+    void slotItemActivated(QTreeWidgetItem* item);
+
+signals:
+    /**
+     * Requests that the given thread is selected.
+     */
+    void setThread(int);
+};
+
+#endif // STACKGROUPWND_H
@@ -0,0 +1,88 @@
+/*
+ * Copyright Johannes Sixt
+ * This file is licensed under the GNU General Public License Version 2.
+ * See the file COPYING in the toplevel directory of the source directory.
+ */
+
+#include "statwnd.h"
+#include <klocale.h>
+#include <QHeaderView>
+
+
+StatisticsWindow::StatisticsWindow(QWidget* parent) :
+	QTreeWidget(parent)
+{
+    setHeaderLabels(QStringList() << i18n("Command") << i18n("Count")
+		    << i18n("Queued") << i18n("Sent") << i18n("Output")
+		    << i18n("Total") << i18n("Max") << i18n("Bytes")
+		    << i18n("Parse (us)") << i18n("KB/s") << i18n("Values"));
+    header()->setResizeMode(0, QHeaderView::Interactive);
+    setSortingEnabled(true);
+    sortByColumn(5, Qt::DescendingOrder);
+}
+
+StatisticsWindow::~StatisticsWindow()
+{
+}
+
+/*
+ * The columns show the average milliseconds that a command waited in the
+ * queue, until the debugger acknowledged it, until its first output
+ * arrived, and in total. Then follow the average size of the output, the
+ * time needed to parse it, the resulting throughput of the parser, and
+ * how many ExprValues it created. The children of each command list the histogram
+ * of the total times.
+ */
+void StatisticsWindow::updateStatistics(const std::map<DbgCommand,CmdStatistics>& stats)
+{
+    // remember which commands show their histogram
+    QStringList expanded;
+    for (int i = 0; i < topLevelItemCount(); i++) {
+	if (topLevelItem(i)->isExpanded())
+	    expanded.append(topLevelItem(i)->text(0));
+    }
+
+    clear();
+
+    std::map<DbgCommand,CmdStatistics>::const_iterator it;
+    for (it = stats.begin(); it != stats.end(); ++it)
+    {
+	const CmdStatistics& s = it->second;
+	if (s.count == 0)
+	    continue;
+	QTreeWidgetItem* item = new QTreeWidgetItem(this);
+	item->setText(0, DebuggerDriver::commandName(it->first));
+	item->setData(1, Qt::DisplayRole, s.count);
+	item->setData(2, Qt::DisplayRole, s.totalWait / s.count);
+	item->setData(3, Qt::DisplayRole, s.totalAck / s.count);
+	item->setData(4, Qt::DisplayRole, s.totalFirst / s.count);
+	item->setData(5, Qt::DisplayRole, s.totalDone / s.count);
+	item->setData(6, Qt::DisplayRole, s.maxDone);
+	item->setData(7, Qt::DisplayRole, int(s.totalBytes / s.count));
+	item->setData(8, Qt::DisplayRole, int(s.totalParse / s.count));
+	if (s.totalParse > 0)
+	    item->setData(9, Qt::DisplayRole, int(s.totalBytes * 1000000 / 1024 / s.totalParse));
+	item->setData(10, Qt::DisplayRole, int(s.totalAllocs / s.count));
+	for (int c = 1; c <= 10; c++)
+	    item->setTextAlignment(c, Qt::AlignRight);
+
+	int lower = 0;
+	for (int b = 0; b < CmdStatistics::numBuckets; b++)
+	{
+	    int upper = CmdStatistics::bucketLimit(b);
+	    if (s.histogram[b] != 0) {
+		QTreeWidgetItem* bucket = new QTreeWidgetItem(item);
+		if (upper < 0)
+		    bucket->setText(0, i18n("%1 ms and more", lower));
+		else
+		    bucket->setText(0, i18n("%1 - %2 ms", lower, upper-1));
+		bucket->setData(1, Qt::DisplayRole, s.histogram[b]);
+		bucket->setTextAlignment(1, Qt::AlignRight);
+	    }
+	    lower = upper;
+	}
+	item->setExpanded(expanded.contains(item->text(0)));
+    }
+}
+
+#include "statwnd.moc"
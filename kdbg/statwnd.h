@@ -0,0 +1,28 @@
+/*
+ * Copyright Johannes Sixt
+ * This file is licensed under the GNU General Public License Version 2.
+ * See the file COPYING in the toplevel directory of the source directory.
+ */
+
+#ifndef STATWND_H
+#define STATWND_H
+
+#include <QTreeWidget>
+#include <map>
+#include "dbgdriver.h"
+
+/**
+ * Shows how long the commands took that were sent to the debugger, so
+ * that one can tell which of them make stepping slow.
+ */
+class StatisticsWindow : public QTreeWidget
+{
+    Q_OBJECT
+public:
+    StatisticsWindow(QWidget* parent);
+    ~StatisticsWindow();
+
+    void updateStatistics(const std::map<DbgCommand,CmdStatistics>& stats);
+};
+
+#endif // STATWND_H
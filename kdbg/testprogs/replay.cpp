@@ -0,0 +1,325 @@
+/*
+ * Copyright Johannes Sixt
+ * This file is licensed under the GNU General Public License Version 2.
+ * See the file COPYING in the toplevel directory of the source directory.
+ */
+
+/*
+ * Replays a transcript that kdbg wrote with -t through the parsers of the
+ * gdb driver, without a running gdb, and reports for each command type
+ * how fast its output was parsed and how many ExprValues were created.
+ *
+ * Usage: replay [-n repeat] transcript...
+ */
+
+#include "gdbdriver.h"
+#include "exprwnd.h"
+#include <QFile>
+#include <QElapsedTimer>
+#include <kcomponentdata.h>
+#include <queue>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>			/* atoi */
+#include <string.h>
+
+
+// the prompt that GdbDriver sets up
+static const char prompt[] = "(kdbg)";
+static const int promptLen = sizeof(prompt)-1;
+
+struct Response
+{
+    DbgCommand cmd;
+    QByteArray output;
+};
+
+struct Totals
+{
+    int count;
+    qint64 bytes;
+    qint64 nsecs;
+    unsigned long allocations;
+    Totals() : count(0), bytes(0), nsecs(0), allocations(0) { }
+};
+
+/*
+ * The driver is never started; it only provides the parsers and the
+ * command formats.
+ */
+class ReplayDriver : public GdbDriver
+{
+public:
+    /**
+     * Finds the command whose format produced the line \a line (without
+     * the line feed). The longest matching format wins.
+     */
+    bool matchCommand(const QByteArray& line, DbgCommand& cmd) const;
+    /**
+     * Adjusts the command formats to the gdb that wrote the transcript.
+     */
+    void setVersion(const QByteArray& banner) { parseGdbVersion(banner); }
+};
+
+bool ReplayDriver::matchCommand(const QByteArray& line, DbgCommand& cmd) const
+{
+    int best = 0;
+    // DCbtrange is the last command
+    for (int i = 0; i <= DCbtrange; i++) {
+	const char* fmt = cmdFormat(DbgCommand(i));
+	const char* perc = strchr(fmt, '%');
+	const char* end = perc != 0 ? perc : strchr(fmt, '\n');
+	int len = end != 0 ? end-fmt : 0;
+	if (len <= best || line.length() < len ||
+	    strncmp(line.constData(), fmt, len) != 0)
+	    continue;
+	// a command without arguments must match completely
+	if (perc == 0 && line.length() != len)
+	    continue;
+	best = len;
+	cmd = DbgCommand(i);
+    }
+    return best > 0;
+}
+
+/*
+ * Removes the lines that kdbg adds to the transcript, such as
+ * "====== idle after ... ======".
+ */
+static void removeMarkers(QByteArray& log)
+{
+    static const char marker[] = "\n====== ";
+    int pos;
+    while ((pos = log.indexOf(marker)) >= 0) {
+	int end = log.indexOf(" ======\n", pos+1);
+	if (end < 0)
+	    break;
+	log.remove(pos, end+8-pos);
+    }
+}
+
+/*
+ * Splits the transcript into the responses of gdb. kdbg writes its
+ * commands right after a prompt, several at once if they are sent ahead;
+ * the responses follow in the same order, each ended by a prompt. The
+ * initialization commands are written before gdb's banner arrives; they
+ * do not match any command format.
+ */
+static void splitTranscript(ReplayDriver& drv, QByteArray log,
+			    std::list<Response>& responses)
+{
+    removeMarkers(log);
+
+    std::queue<DbgCommand> pending;
+    bool startup = true;
+    int pos = 0;
+    for (;;) {
+	// pick up the commands that were written after the prompt
+	int eol;
+	DbgCommand cmd;
+	while ((eol = log.indexOf('\n', pos)) >= 0 &&
+	       drv.matchCommand(log.mid(pos, eol-pos), cmd))
+	{
+	    pending.push(cmd);
+	    pos = eol+1;
+	    startup = false;
+	}
+
+	int end = log.indexOf(prompt, pos);
+	if (end < 0)
+	    break;
+	QByteArray output = log.mid(pos, end-pos);
+	if (!pending.empty()) {
+	    Response r;
+	    r.cmd = pending.front();
+	    r.output = output;
+	    responses.push_back(r);
+	    pending.pop();
+	} else if (startup && output.contains("GNU gdb")) {
+	    drv.setVersion(output);
+	}
+	pos = end + promptLen;
+    }
+}
+
+/*
+ * Feeds the output to the parser that KDebugger uses for the command.
+ * Returns false if the output of the command is not parsed.
+ */
+static bool parseResponse(ReplayDriver& drv, DbgCommand cmd, const char* output)
+{
+    QString msg, file, addrFrom, addrTo;
+    int id, frameNo, lineNo;
+    DbgAddr address;
+
+    switch (cmd) {
+    case DCinfolocals:
+    case DCframelocals:
+	{
+	    std::list<ExprValue*> vars;
+	    drv.parseLocals(output, vars);
+	    for (std::list<ExprValue*>::iterator i = vars.begin(); i != vars.end(); ++i)
+		delete *i;
+	}
+	break;
+    case DCprint:
+    case DCprintDeref:
+    case DCprintStruct:
+    case DCprintPopup:
+    case DCprintStructBatch:
+    case DCprintPage:
+	delete drv.parsePrintExpr(output, true);
+	break;
+    case DCprintQStringStruct:
+    case DCprintWChar:
+	delete drv.parseQCharArray(output, false, true);
+	break;
+    case DCbt:
+    case DCbtrange:
+	{
+	    std::list<StackFrame> stack;
+	    drv.parseBackTrace(output, stack);
+	}
+	break;
+    case DCframe:
+	drv.parseFrameChange(output, frameNo, file, lineNo, address);
+	break;
+    case DCbtall:
+	drv.parseThreadStacks(output);
+	break;
+    case DCinfothreads:
+	drv.parseThreadList(output);
+	break;
+    case DCinfobreak:
+	{
+	    std::list<Breakpoint> brks;
+	    drv.parseBreakList(output, brks);
+	}
+	break;
+    case DCbreaktext:
+    case DCbreakline:
+    case DCtbreakline:
+    case DCbreakaddr:
+    case DCtbreakaddr:
+    case DCwatchpoint:
+    case DClogpoint:
+	drv.parseBreakpoint(output, id, file, lineNo, addrFrom);
+	break;
+    case DCfindType:
+	drv.parseFindType(output, msg);
+	break;
+    case DCinforegisters:
+    case DCregistervalues:
+	drv.parseRegisters(output);
+	break;
+    case DCinfoline:
+	drv.parseInfoLine(output, addrFrom, addrTo);
+	break;
+    case DCdisassemble:
+	drv.parseDisassemble(output);
+	break;
+    case DCexamine:
+	{
+	    std::list<MemoryDump> memdump;
+	    drv.parseMemoryDump(output, memdump);
+	}
+	break;
+    case DCsetvariable:
+	drv.parseSetVariable(output);
+	break;
+    case DCinfosharedlib:
+	drv.parseSharedLibs(output);
+	break;
+    case DCattach:
+    case DCrun:
+    case DCcont:
+    case DCstep:
+    case DCstepi:
+    case DCnext:
+    case DCnexti:
+    case DCfinish:
+    case DCuntil:
+    case DCthread:
+	drv.parseProgramStopped(output, msg);
+	break;
+    case DCcd:
+	drv.parseChangeWD(output, msg);
+	break;
+    case DCexecutable:
+	drv.parseChangeExecutable(output, msg);
+	break;
+    case DCcorefile:
+	drv.parseCoreFile(output);
+	break;
+    default:
+	return false;
+    }
+    return true;
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: replay [-n repeat] transcript...\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    // i18n() needs a component
+    KComponentData component("kdbg");
+
+    int repeat = 1;
+    int argi = 1;
+    if (argi+1 < argc && strcmp(argv[argi], "-n") == 0) {
+	repeat = atoi(argv[argi+1]);
+	argi += 2;
+    }
+    if (argi >= argc || repeat <= 0)
+	usage();
+
+    ReplayDriver drv;
+    std::list<Response> responses;
+    for (; argi < argc; argi++) {
+	QFile f(argv[argi]);
+	if (!f.open(QIODevice::ReadOnly)) {
+	    fprintf(stderr, "replay: cannot open %s\n", argv[argi]);
+	    return 1;
+	}
+	splitTranscript(drv, f.readAll(), responses);
+    }
+
+    std::map<DbgCommand,Totals> totals;
+    int unparsed = 0;
+    for (int n = 0; n < repeat; n++) {
+	for (std::list<Response>::iterator r = responses.begin(); r != responses.end(); ++r)
+	{
+	    unsigned long allocs = ExprValue::allocations();
+	    QElapsedTimer timer;
+	    timer.start();
+	    if (!parseResponse(drv, r->cmd, r->output.constData())) {
+		unparsed++;
+		continue;
+	    }
+	    qint64 nsecs = timer.nsecsElapsed();
+	    Totals& t = totals[r->cmd];
+	    t.count++;
+	    t.bytes += r->output.size();
+	    t.nsecs += nsecs;
+	    t.allocations += ExprValue::allocations() - allocs;
+	}
+    }
+
+    printf("%-22s %7s %10s %10s %9s %11s\n",
+	   "# command", "count", "bytes", "parse (us)", "MB/s", "ExprValues");
+    for (std::map<DbgCommand,Totals>::iterator i = totals.begin(); i != totals.end(); ++i)
+    {
+	const Totals& t = i->second;
+	double mbps = t.nsecs > 0 ? t.bytes * 1000.0 / t.nsecs : 0.0;
+	printf("%-22s %7d %10lld %10lld %9.1f %11lu\n",
+	       DebuggerDriver::commandName(i->first), t.count,
+	       (long long) t.bytes, (long long) (t.nsecs / 1000), mbps,
+	       t.allocations);
+    }
+    printf("# %d responses without a parser\n", unparsed / repeat);
+    return 0;
+}
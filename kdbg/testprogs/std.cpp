@@ -13,7 +13,7 @@ struct V : std::vector<T>
 	V(const T& v) : std::vector<T>(10, v) {}
 	void anotherone(const T& v)
 	{
-		push_back(v);
+		this->push_back(v);
 	}
 };
 
@@ -16,14 +16,14 @@
 class ThreadEntry : public QTreeWidgetItem, public ThreadInfo
 {
 public:
-    ThreadEntry(QTreeWidget* parent, const ThreadInfo& thread);
+    ThreadEntry(const ThreadInfo& thread);
     void setFunction(const QString& func);
 
     bool m_delete;			/* used for updating the list */
 };
 
-ThreadEntry::ThreadEntry(QTreeWidget* parent, const ThreadInfo& thread) :
-	QTreeWidgetItem(parent, QStringList() << thread.threadName << thread.function),
+ThreadEntry::ThreadEntry(const ThreadInfo& thread) :
+	QTreeWidgetItem(QStringList() << thread.threadName << thread.function),
 	ThreadInfo(thread),
 	m_delete(false)
 {
@@ -31,24 +31,42 @@ ThreadEntry::ThreadEntry(QTreeWidget* parent, const ThreadInfo& thread) :
 
 void ThreadEntry::setFunction(const QString& func)
 {
+    // repaint only rows that changed
+    if (func == function)
+	return;
     function = func;
     setText(1, function);
 }
 
 
 ThreadList::ThreadList(QWidget* parent) :
-	QTreeWidget(parent)
+	QWidget(parent),
+	m_filter(this),
+	m_list(this),
+	m_layout(this)
 {
-    setHeaderLabels(QStringList() << i18n("Thread ID") << i18n("Location"));
-    header()->setResizeMode(1, QHeaderView::Interactive);
-    setRootIsDecorated(false);
+    m_layout.setMargin(0);
+    m_layout.setSpacing(0);
+    m_layout.addWidget(&m_filter);
+    m_layout.addWidget(&m_list);
+
+    m_filter.setPlaceholderText(i18n("Filter threads"));
+    m_filter.setToolTip(i18n("Show only threads whose ID or location contain this text"));
+
+    m_list.setHeaderLabels(QStringList() << i18n("Thread ID") << i18n("Location"));
+    m_list.header()->setResizeMode(1, QHeaderView::Interactive);
+    m_list.setRootIsDecorated(false);
+    // lets the view lay out only the rows that are in view
+    m_list.setUniformRowHeights(true);
 
     // load pixmaps
     m_focusIcon = UserIcon("pcinner");
     makeNoFocusIcon();
 
-    connect(this, SIGNAL(currentItemChanged(QTreeWidgetItem*, QTreeWidgetItem*)),
+    connect(&m_list, SIGNAL(currentItemChanged(QTreeWidgetItem*, QTreeWidgetItem*)),
 	    this, SLOT(slotCurrentChanged(QTreeWidgetItem*)));
+    connect(&m_filter, SIGNAL(textChanged(const QString&)),
+	    this, SLOT(slotFilterChanged(const QString&)));
 }
 
 ThreadList::~ThreadList()
@@ -58,45 +76,69 @@ ThreadList::~ThreadList()
 void ThreadList::updateThreads(const std::list<ThreadInfo>& threads)
 {
     // reset flag in all items
-    for (QTreeWidgetItemIterator i(this); *i; ++i)
-	static_cast<ThreadEntry*>(*i)->m_delete = true;
+    for (QHash<int,ThreadEntry*>::iterator i = m_threads.begin(); i != m_threads.end(); ++i)
+	(*i)->m_delete = true;
 
+    QList<QTreeWidgetItem*> newEntries;
     for (std::list<ThreadInfo>::const_iterator i = threads.begin(); i != threads.end(); ++i)
     {
 	// look up this thread by id
 	ThreadEntry* te = threadById(i->id);
+	bool focusChanged;
 	if (te == 0) {
-	    te = new ThreadEntry(this, *i);
+	    te = new ThreadEntry(*i);
+	    m_threads.insert(te->id, te);
+	    newEntries.append(te);
+	    focusChanged = true;
 	} else {
 	    te->m_delete = false;
 	    te->setFunction(i->function);
+	    focusChanged = te->hasFocus != i->hasFocus;
 	}
 	// set focus icon
-	te->hasFocus = i->hasFocus;
-	te->setIcon(0, i->hasFocus  ?  QIcon(m_focusIcon)  :  QIcon(m_noFocusIcon));
+	if (focusChanged) {
+	    te->hasFocus = i->hasFocus;
+	    te->setIcon(0, i->hasFocus  ?  QIcon(m_focusIcon)  :  QIcon(m_noFocusIcon));
+	}
+    }
+
+    // a single insertion is much cheaper than one per thread
+    m_list.addTopLevelItems(newEntries);
+    if (!m_filter.text().isEmpty()) {
+	for (QList<QTreeWidgetItem*>::iterator i = newEntries.begin(); i != newEntries.end(); ++i)
+	    (*i)->setHidden(!matchesFilter(static_cast<ThreadEntry*>(*i)));
     }
 
     // delete all entries that have not been seen
-    for (QTreeWidgetItemIterator i(this); *i;)
+    for (QHash<int,ThreadEntry*>::iterator i = m_threads.begin(); i != m_threads.end();)
     {
-	ThreadEntry* te = static_cast<ThreadEntry*>(*i);
-	++i;		// step ahead before deleting it ;-)
+	ThreadEntry* te = *i;
 	if (te->m_delete) {
+	    i = m_threads.erase(i);
 	    delete te;
+	} else {
+	    ++i;
 	}
     }
 }
 
-ThreadEntry* ThreadList::threadById(int id)
+ThreadEntry* ThreadList::threadById(int id) const
 {
-    for (QTreeWidgetItemIterator i(this); *i; ++i)
-    {
-	ThreadEntry* te = static_cast<ThreadEntry*>(*i);
-	if (te->id == id) {
-	    return te;
-	}
-    }
-    return 0;
+    return m_threads.value(id, 0);
+}
+
+bool ThreadList::matchesFilter(const ThreadEntry* te) const
+{
+    QString filter = m_filter.text();
+    return QString::number(te->id) == filter ||
+	te->threadName.contains(filter, Qt::CaseInsensitive) ||
+	te->function.contains(filter, Qt::CaseInsensitive);
+}
+
+void ThreadList::slotFilterChanged(const QString&)
+{
+    for (QHash<int,ThreadEntry*>::iterator i = m_threads.begin(); i != m_threads.end(); ++i)
+	(*i)->setHidden(!matchesFilter(*i));
 }
 
 /*
@@ -8,13 +8,21 @@
 #define THREADLIST_H
 
 #include <QTreeWidget>
+#include <QLineEdit>
+#include <QVBoxLayout>
 #include <QPixmap>
+#include <QHash>
 #include <list>
 
 class ThreadInfo;
 class ThreadEntry;
 
-class ThreadList : public QTreeWidget
+/**
+ * The list of threads with a filter box above it. The filter narrows the
+ * list to threads whose ID or location contain the text; it does not
+ * need the debugger.
+ */
+class ThreadList : public QWidget
 {
     Q_OBJECT
 public:
@@ -24,14 +32,20 @@ public:
 public slots:
     void updateThreads(const std::list<ThreadInfo>&);
     void slotCurrentChanged(QTreeWidgetItem*);
+    void slotFilterChanged(const QString& text);
 
 signals:
     void setThread(int);
 
 protected:
-    ThreadEntry* threadById(int id);
+    ThreadEntry* threadById(int id) const;
+    bool matchesFilter(const ThreadEntry* te) const;
     void makeNoFocusIcon();
 
+    QLineEdit m_filter;
+    QTreeWidget m_list;
+    QVBoxLayout m_layout;
+    QHash<int,ThreadEntry*> m_threads;	/* the entries by thread id */
     QPixmap m_focusIcon;
     QPixmap m_noFocusIcon;
 };
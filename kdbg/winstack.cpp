@@ -175,6 +175,27 @@ void WinStack::updateLineItems(const KDebugger* dbg)
     }
 }
 
+void WinStack::updateBreakpoint(const Breakpoint& bp)
+{
+    for (int i = count()-1; i >= 0; i--) {
+	windowAt(i)->updateBreakpoint(bp);
+    }
+}
+
+void WinStack::removeBreakpoint(const KDebugger* dbg, const Breakpoint& bp)
+{
+    for (int i = count()-1; i >= 0; i--) {
+	windowAt(i)->removeBreakpoint(dbg, bp);
+    }
+}
+
+void WinStack::updateBreakpointRates(const KDebugger* dbg)
+{
+    for (int i = count()-1; i >= 0; i--) {
+	windowAt(i)->updateBreakpointRates(dbg);
+    }
+}
+
 void WinStack::updatePC(const QString& fileName, int lineNo, const DbgAddr& address, int frameNo)
 {
     if (m_pcLine >= 0) {
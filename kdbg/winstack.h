@@ -22,6 +22,7 @@ class WinStack;
 class SourceWindow;
 class DisassembledCode;
 struct DbgAddr;
+struct Breakpoint;
 
 class FindDialog : public QDialog
 {
@@ -88,6 +89,9 @@ public slots:
     void updatePC(const QString& filename, int lineNo, const DbgAddr& address, int frameNo);
     void reloadAllFiles();
     void updateLineItems(const KDebugger* deb);
+    void updateBreakpoint(const Breakpoint& bp);
+    void removeBreakpoint(const KDebugger* deb, const Breakpoint& bp);
+    void updateBreakpointRates(const KDebugger* deb);
     void slotSetTabWidth(int numChars);
 
     void slotFileReload();
@@ -45,7 +45,7 @@ struct XsldbgCmdInfo {
  * The following array of commands must be sorted by the DC* values,
  * because they are used as indices.
  */
-static XsldbgCmdInfo cmds[] = {
+static const XsldbgCmdInfo cmds[] = {
     {DCinitialize, "init\n", XsldbgCmdInfo::argNone},
     {DCtty, "tty %s\n", XsldbgCmdInfo::argString},
     {DCexecutable, "source %s\n", XsldbgCmdInfo::argString},    /* force a restart */
@@ -63,7 +63,7 @@ static XsldbgCmdInfo cmds[] = {
     {DCunsetenv, "unset env %s\n", XsldbgCmdInfo::argString},
     {DCsetoption, "setoption %s %d\n", XsldbgCmdInfo::argStringNum},
     {DCcd, "chdir %s\n", XsldbgCmdInfo::argString},
-    {DCbt, "where\n", XsldbgCmdInfo::argNone},
+    {DCbt, "where\n", XsldbgCmdInfo::argNum},
     {DCrun, "run\nsource\n", XsldbgCmdInfo::argNone}, /* Ensure that at the start
 							 of executing XSLT we show the XSLT file */
     {DCcont, "continue\n", XsldbgCmdInfo::argNone},
@@ -99,6 +99,15 @@ static XsldbgCmdInfo cmds[] = {
     {DCignore, "print 'ignore %d %d'\n", XsldbgCmdInfo::argNum2},
     {DCprintWChar, "print 'ignore %s'\n", XsldbgCmdInfo::argString},
     {DCsetvariable, "set %s %s\n", XsldbgCmdInfo::argString2},
+    {DCprintStructBatch, "print 'print %s'\n", XsldbgCmdInfo::argString},
+    {DCprintPage, "print %s\n", XsldbgCmdInfo::argString},
+    {DCframelocals, "print 'frame locals %d'\n", XsldbgCmdInfo::argNum},
+    {DCbtall, "print 'thread apply all bt'\n", XsldbgCmdInfo::argNone},
+    {DCregistervalues, "print 'info reg %s'\n", XsldbgCmdInfo::argString},
+    {DCbreakbatch, "%s", XsldbgCmdInfo::argString},
+    {DClogpoint, "print 'dprintf %s'\n", XsldbgCmdInfo::argString},
+    {DCtargetcond, "print 'set breakpoint condition-evaluation target'\n", XsldbgCmdInfo::argNone},
+    {DCbtrange, "print 'frame apply level %d-%d -q frame'\n", XsldbgCmdInfo::argNum2},
 };
 
 #define NUM_CMDS (int(sizeof(cmds)/sizeof(cmds[0])))
@@ -265,7 +274,7 @@ XsldbgDriver::commandFinished(CmdQueueItem * cmd)
 }
 
 int
-XsldbgDriver::findPrompt(const QByteArray& output) const
+XsldbgDriver::findPrompt(const QByteArray& output, int& /*scanned*/, int& promptEnd)
 {
     /*
      * If there's a prompt string in the collected output, it must be at
@@ -279,6 +288,7 @@ XsldbgDriver::findPrompt(const QByteArray& output) const
     // There can be text between "(xsldbg) " and the "> " at the end
     // since we do not know what that text is, we accept the former
     // anywhere in the output.
+    promptEnd = len;
     return output.indexOf("(xsldbg) ");
 }
 
@@ -371,6 +381,15 @@ XsldbgDriver::makeCmdString(DbgCommand cmd, QString strArg)
     return cmdString;
 }
 
+QString
+XsldbgDriver::commandString(DbgCommand cmd, QString strArg, int intArg)
+{
+    assert(cmd >= 0 && cmd < NUM_CMDS);
+    if (cmds[cmd].argsNeeded == XsldbgCmdInfo::argStringNum)
+        return makeCmdString(cmd, strArg, intArg);
+    return makeCmdString(cmd, strArg);
+}
+
 QString
 XsldbgDriver::makeCmdString(DbgCommand cmd, int intArg)
 {
@@ -588,6 +607,13 @@ XsldbgDriver::queueCmd(DbgCommand cmd, QString strArg1, QString strArg2,
     return queueCmdString(cmd, makeCmdString(cmd, strArg1, strArg2), mode);
 }
 
+CmdQueueItem *
+XsldbgDriver::queueCmd(DbgCommand cmd, int intArg1, int intArg2,
+                       QueueMode mode)
+{
+    return queueCmdString(cmd, makeCmdString(cmd, intArg1, intArg2), mode);
+}
+
 void
 XsldbgDriver::terminate()
 {
@@ -1043,7 +1069,7 @@ parseFrame(const char *&s, int &frameNo, QString & func,
     return true;
 }
 
-void
+bool
 XsldbgDriver::parseBackTrace(const char *output,
                              std::list < StackFrame > &stack)
 {
@@ -1061,6 +1087,8 @@ XsldbgDriver::parseBackTrace(const char *output,
         frm->address = address;
         frm->var = new ExprValue(func, VarTree::NKplain);
     }
+    // where lists all frames
+    return false;
 }
 
 bool
@@ -1209,6 +1237,12 @@ XsldbgDriver::parseThreadList(const char */*output*/)
     return std::list<ThreadInfo>();
 }
 
+std::list<ThreadStack>
+XsldbgDriver::parseThreadStacks(const char */*output*/)
+{
+    return std::list<ThreadStack>();
+}
+
 bool
 XsldbgDriver::parseBreakpoint(const char *output, int &id,
                               QString &file, int &lineNo, QString &address)
@@ -1274,6 +1308,15 @@ XsldbgDriver::parsePrintExpr(const char *output, bool wantErrorValue)
     return var;
 }
 
+std::list<QByteArray>
+XsldbgDriver::parseBatchOutput(const char *output)
+{
+    // there are no type tables for XSLT; a batch has only one line
+    std::list<QByteArray> parts;
+    parts.push_back(QByteArray(output));
+    return parts;
+}
+
 bool
 XsldbgDriver::parseChangeWD(const char *output, QString & message)
 {
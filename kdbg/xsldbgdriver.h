@@ -42,6 +42,8 @@ class XsldbgDriver:public DebuggerDriver {
                                    QueueMode mode);
     virtual CmdQueueItem *queueCmd(DbgCommand, QString strArg1,
                                    QString strArg2, QueueMode mode);
+    virtual CmdQueueItem *queueCmd(DbgCommand, int intArg1, int intArg2,
+                                   QueueMode mode);
 
     virtual void terminate();
     virtual void detachAndTerminate();
@@ -54,7 +56,7 @@ class XsldbgDriver:public DebuggerDriver {
     virtual ExprValue *parseQCharArray(const char *output,
                                      bool wantErrorValue, bool qt3like);
 
-    virtual void parseBackTrace(const char *output,
+    virtual bool parseBackTrace(const char *output,
                                 std::list < StackFrame > &stack);
     virtual bool parseFrameChange(const char *output, int &frameNo,
                                   QString & file, int &lineNo,
@@ -62,11 +64,14 @@ class XsldbgDriver:public DebuggerDriver {
     virtual bool parseBreakList(const char *output,
                                 std::list < Breakpoint > &brks);
     virtual std::list<ThreadInfo> parseThreadList(const char *output);
+    virtual std::list<ThreadStack> parseThreadStacks(const char *output);
+    virtual QString commandString(DbgCommand cmd, QString strArg, int intArg);
     virtual bool parseBreakpoint(const char *output, int &id,
                                  QString & file, int &lineNo, QString& address);
     virtual void parseLocals(const char *output,
                              std::list < ExprValue* > &newVars);
     virtual ExprValue * parsePrintExpr(const char *output, bool wantErrorValue);
+    virtual std::list<QByteArray> parseBatchOutput(const char *output);
     virtual bool parseChangeWD(const char *output, QString & message);
     virtual bool parseChangeExecutable(const char *output,
                                        QString & message);
@@ -96,7 +101,7 @@ class XsldbgDriver:public DebuggerDriver {
     QString makeCmdString(DbgCommand cmd, QString strArg1,
                           QString strArg2);
     QString makeCmdString(DbgCommand cmd, int intArg1, int intArg2);
-    virtual int findPrompt(const QByteArray& output) const;
+    virtual int findPrompt(const QByteArray& output, int& scanned, int& promptEnd);
     void parseMarker();
 };
 